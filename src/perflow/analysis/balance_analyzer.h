@@ -0,0 +1,181 @@
+#ifndef PERFLOW_ANALYSIS_BALANCE_ANALYZER_H_
+#define PERFLOW_ANALYSIS_BALANCE_ANALYZER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "perflow/analysis/performance_tree.h"
+
+namespace perflow {
+namespace analysis {
+
+/** Load-balance statistics across processes. */
+struct BalanceAnalysisResult {
+  std::vector<double> process_samples; /**<total samples per process */
+  double mean_samples = 0.0;
+  double std_dev_samples = 0.0;
+  double min_samples = 0.0;
+  double max_samples = 0.0;
+  size_t least_loaded_process = 0;
+  size_t most_loaded_process = 0;
+  double imbalance_factor = 0.0; /**<max / mean, 1.0 is perfectly balanced */
+};
+
+/** Computes per-process load statistics over a performance tree. */
+class BalanceAnalyzer {
+public:
+  BalanceAnalysisResult analyze(const PerformanceTree &tree) const {
+    BalanceAnalysisResult result;
+    size_t process_count = tree.process_count();
+    if (process_count == 0) {
+      return result;
+    }
+    result.process_samples.assign(process_count, 0.0);
+
+    // Per-process totals are the sums over the root's direct children.
+    for (const auto &node : tree.root()->children()) {
+      const auto &counts = node->sampling_counts();
+      for (size_t pid = 0; pid < counts.size() && pid < process_count;
+           pid++) {
+        result.process_samples[pid] += static_cast<double>(counts[pid]);
+      }
+    }
+
+#ifdef __AVX2__
+    if (process_count >= 16) {
+      analyze_avx2(result, process_count);
+      return result;
+    }
+#endif
+
+    // Welford's online algorithm: mean and variance in one pass over the
+    // samples, with min/max/argmin/argmax tracked in the same loop.
+    double mean = 0.0;
+    double m2 = 0.0;
+    size_t n = 0;
+    double min_val = result.process_samples[0];
+    double max_val = result.process_samples[0];
+    for (size_t i = 0; i < process_count; i++) {
+      double x = result.process_samples[i];
+      ++n;
+      double delta = x - mean;
+      mean += delta / static_cast<double>(n);
+      double delta2 = x - mean;
+      m2 += delta * delta2;
+      min_val = std::min(min_val, x);
+      max_val = std::max(max_val, x);
+    }
+
+    // Argmin/argmax recovered afterwards: keeps the statistics loop free
+    // of data-dependent index writes (mirrors the AVX2 path).
+    size_t min_idx = 0;
+    size_t max_idx = 0;
+    for (size_t i = 0; i < process_count; i++) {
+      if (result.process_samples[i] == min_val) {
+        min_idx = i;
+        break;
+      }
+    }
+    for (size_t i = 0; i < process_count; i++) {
+      if (result.process_samples[i] == max_val) {
+        max_idx = i;
+        break;
+      }
+    }
+
+    result.mean_samples = mean;
+    result.std_dev_samples =
+        std::sqrt(m2 / static_cast<double>(process_count));
+    result.min_samples = min_val;
+    result.max_samples = max_val;
+    result.least_loaded_process = min_idx;
+    result.most_loaded_process = max_idx;
+    result.imbalance_factor = mean == 0.0 ? 0.0 : max_val / mean;
+    return result;
+  }
+
+private:
+#ifdef __AVX2__
+  /** Vectorized statistics: 4-wide sum/min/max reduction, then an
+   * FMA-based variance pass against the broadcast mean. The argmin/argmax
+   * indices are recovered afterwards by a scalar equality scan, keeping
+   * the hot loops free of data-dependent branches. */
+  void analyze_avx2(BalanceAnalysisResult &result,
+                    size_t process_count) const {
+    const double *samples = result.process_samples.data();
+    size_t vec_end = process_count & ~size_t(3);
+
+    __m256d sum_v = _mm256_setzero_pd();
+    __m256d min_v = _mm256_set1_pd(samples[0]);
+    __m256d max_v = min_v;
+    for (size_t i = 0; i < vec_end; i += 4) {
+      __m256d x = _mm256_loadu_pd(samples + i);
+      sum_v = _mm256_add_pd(sum_v, x);
+      min_v = _mm256_min_pd(min_v, x);
+      max_v = _mm256_max_pd(max_v, x);
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, sum_v);
+    double sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_store_pd(lanes, min_v);
+    double min_val = std::min(std::min(lanes[0], lanes[1]),
+                              std::min(lanes[2], lanes[3]));
+    _mm256_store_pd(lanes, max_v);
+    double max_val = std::max(std::max(lanes[0], lanes[1]),
+                              std::max(lanes[2], lanes[3]));
+    for (size_t i = vec_end; i < process_count; i++) {
+      sum += samples[i];
+      min_val = std::min(min_val, samples[i]);
+      max_val = std::max(max_val, samples[i]);
+    }
+    double mean = sum / static_cast<double>(process_count);
+
+    __m256d mean_v = _mm256_set1_pd(mean);
+    __m256d m2_v = _mm256_setzero_pd();
+    for (size_t i = 0; i < vec_end; i += 4) {
+      __m256d d = _mm256_sub_pd(_mm256_loadu_pd(samples + i), mean_v);
+      m2_v = _mm256_fmadd_pd(d, d, m2_v);
+    }
+    _mm256_store_pd(lanes, m2_v);
+    double m2 = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (size_t i = vec_end; i < process_count; i++) {
+      double d = samples[i] - mean;
+      m2 += d * d;
+    }
+
+    size_t min_idx = 0;
+    size_t max_idx = 0;
+    for (size_t i = 0; i < process_count; i++) {
+      if (samples[i] == min_val) {
+        min_idx = i;
+        break;
+      }
+    }
+    for (size_t i = 0; i < process_count; i++) {
+      if (samples[i] == max_val) {
+        max_idx = i;
+        break;
+      }
+    }
+
+    result.mean_samples = mean;
+    result.std_dev_samples = std::sqrt(m2 / static_cast<double>(process_count));
+    result.min_samples = min_val;
+    result.max_samples = max_val;
+    result.least_loaded_process = min_idx;
+    result.most_loaded_process = max_idx;
+    result.imbalance_factor = mean == 0.0 ? 0.0 : max_val / mean;
+  }
+#endif
+};
+
+} // namespace analysis
+} // namespace perflow
+
+#endif
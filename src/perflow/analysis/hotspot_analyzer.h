@@ -0,0 +1,150 @@
+#ifndef PERFLOW_ANALYSIS_HOTSPOT_ANALYZER_H_
+#define PERFLOW_ANALYSIS_HOTSPOT_ANALYZER_H_
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "perflow/analysis/performance_tree.h"
+
+namespace perflow {
+namespace analysis {
+
+/** One entry of a hotspot report. */
+struct HotspotInfo {
+  std::string function_name;
+  std::string library_name;
+  std::string source_location; /**<"file:line", empty if unknown */
+  uint64_t total_samples = 0;
+  uint64_t self_samples = 0;
+  double total_percentage = 0.0;
+  double self_percentage = 0.0;
+};
+
+/** Ranks tree nodes by (inclusive or exclusive) sample counts. */
+class HotspotAnalyzer {
+public:
+  /** Top nodes by inclusive sample count. */
+  std::vector<HotspotInfo> find_hotspots(const PerformanceTree &tree,
+                                         size_t top_n = 10) const {
+    std::vector<const TreeNode *> nodes;
+    collect_nodes(tree.root().get(), nodes);
+
+    uint64_t total_samples = 0;
+    for (const auto &node : tree.root()->children()) {
+      total_samples += node->total_samples();
+    }
+    if (total_samples == 0) {
+      return {};
+    }
+    // One division up front; each hotspot then pays two multiplies
+    // instead of two divisions.
+    const double inv_total = 100.0 / static_cast<double>(total_samples);
+
+    size_t keep = std::min(top_n, nodes.size());
+    // Only the top_n entries are reported: partial_sort is
+    // O(N log top_n) instead of a full O(N log N) sort.
+    std::partial_sort(nodes.begin(), nodes.begin() + keep, nodes.end(),
+                      [](const TreeNode *a, const TreeNode *b) {
+                        return a->total_samples() > b->total_samples();
+                      });
+
+    std::vector<HotspotInfo> hotspots;
+    hotspots.reserve(keep);
+    for (size_t i = 0; i < keep; i++) {
+      hotspots.push_back(make_info(*nodes[i], inv_total));
+    }
+    return hotspots;
+  }
+
+  /** Top nodes by exclusive (self) sample count. */
+  std::vector<HotspotInfo> find_self_hotspots(const PerformanceTree &tree,
+                                              size_t top_n = 10) const {
+    std::vector<const TreeNode *> nodes;
+    collect_nodes(tree.root().get(), nodes);
+
+    uint64_t total_samples = 0;
+    for (const auto &node : tree.root()->children()) {
+      total_samples += node->total_samples();
+    }
+    if (total_samples == 0) {
+      return {};
+    }
+    const double inv_total = 100.0 / static_cast<double>(total_samples);
+
+    // Nodes with no self samples can never rank; drop them first so the
+    // selection works on the relevant subset only.
+    nodes.erase(std::remove_if(nodes.begin(), nodes.end(),
+                               [](const TreeNode *n) {
+                                 return n->self_samples() == 0;
+                               }),
+                nodes.end());
+
+    size_t keep = std::min(top_n, nodes.size());
+    std::partial_sort(nodes.begin(), nodes.begin() + keep, nodes.end(),
+                      [](const TreeNode *a, const TreeNode *b) {
+                        return a->self_samples() > b->self_samples();
+                      });
+
+    std::vector<HotspotInfo> hotspots;
+    hotspots.reserve(keep);
+    for (size_t i = 0; i < keep; i++) {
+      hotspots.push_back(make_info(*nodes[i], inv_total));
+    }
+    return hotspots;
+  }
+
+private:
+  void collect_nodes(const TreeNode *root,
+                     std::vector<const TreeNode *> &nodes) const {
+    // Iterative DFS with an explicit worklist: no per-node call overhead
+    // and no risk of overflowing the call stack on very deep trees. The
+    // virtual root is the only node to exclude, so seeding the worklist
+    // with its children avoids a per-node string compare against
+    // "[root]".
+    std::vector<const TreeNode *> stack;
+    stack.reserve(1024);
+    for (const auto &child : root->children()) {
+      stack.push_back(child.get());
+    }
+    while (!stack.empty()) {
+      const TreeNode *node = stack.back();
+      stack.pop_back();
+      nodes.push_back(node);
+      for (const auto &child : node->children()) {
+        stack.push_back(child.get());
+      }
+    }
+  }
+
+  HotspotInfo make_info(const TreeNode &node, double inv_total) const {
+    HotspotInfo info;
+    const sampling::ResolvedFrame &frame = node.frame();
+    info.function_name = frame.function_name;
+    info.library_name = frame.library_name;
+    if (!frame.filename.empty()) {
+      // Direct build instead of snprintf("%s:%u"): no format parsing, no
+      // locale, no fixed-size buffer to truncate into.
+      char num_buf[16];
+      auto res = std::to_chars(num_buf, num_buf + sizeof(num_buf),
+                               frame.line_number);
+      info.source_location.reserve(frame.filename.size() + 1 +
+                                   (res.ptr - num_buf));
+      info.source_location.assign(frame.filename);
+      info.source_location.push_back(':');
+      info.source_location.append(num_buf, res.ptr);
+    }
+    info.total_samples = node.total_samples();
+    info.self_samples = node.self_samples();
+    info.total_percentage = static_cast<double>(node.total_samples()) * inv_total;
+    info.self_percentage = static_cast<double>(node.self_samples()) * inv_total;
+    return info;
+  }
+};
+
+} // namespace analysis
+} // namespace perflow
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef PERFLOW_ANALYSIS_OFFSET_CONVERTER_H_
+#define PERFLOW_ANALYSIS_OFFSET_CONVERTER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "perflow/analysis/symbol_resolver.h"
+#include "perflow/sampling/call_stack.h"
+#include "perflow/sampling/library_map.h"
+
+namespace perflow {
+namespace analysis {
+
+/** Converts raw sampled call stacks into resolved call stacks using the
+ * per-process library map snapshots recorded at sampling time. Symbol
+ * resolution is optional and delegated to a SymbolResolver. */
+class OffsetConverter {
+public:
+  OffsetConverter() = default;
+
+  /** Register the library map snapshot of one process/rank. */
+  void add_map_snapshot(uint32_t process_id,
+                        const sampling::LibraryMap &map) {
+    auto it = snapshot_lower_bound(process_id);
+    if (it != map_snapshots_.end() && it->first == process_id) {
+      it->second = map;
+    } else {
+      map_snapshots_.emplace(it, process_id, map);
+    }
+  }
+
+  /** Move overload: callers that build a map and hand it over should not
+   * pay for copying its ranges and name strings. */
+  void add_map_snapshot(uint32_t process_id, sampling::LibraryMap &&map) {
+    auto it = snapshot_lower_bound(process_id);
+    if (it != map_snapshots_.end() && it->first == process_id) {
+      it->second = std::move(map);
+    } else {
+      map_snapshots_.emplace(it, process_id, std::move(map));
+    }
+  }
+
+  bool has_snapshot(uint32_t process_id) const {
+    return find_snapshot(process_id) != nullptr;
+  }
+
+  const sampling::LibraryMap &get_snapshot(uint32_t process_id) const {
+    const sampling::LibraryMap *map = find_snapshot(process_id);
+    if (map == nullptr) {
+      throw std::out_of_range("OffsetConverter: no snapshot for process");
+    }
+    return *map;
+  }
+
+  /** Attach a symbol resolver used when resolve_symbols is requested.
+   * The resolver must outlive the converter; not owned. */
+  void set_symbol_resolver(SymbolResolver *resolver) {
+    symbol_resolver_ = resolver;
+  }
+
+  /** Convert one raw call stack against the snapshot of a process.
+   * @param stack - raw call stack, leaf first.
+   * @param process_id - process/rank whose snapshot to use.
+   * @param resolve_symbols - also resolve function/file/line via the
+   * attached SymbolResolver.
+   * @return the resolved call stack; frames with no covering library keep
+   * the raw address and get library_name "[unknown]".
+   */
+  template <size_t MaxDepth>
+  sampling::ResolvedCallStack
+  convert(const sampling::RawCallStack<MaxDepth> &stack, uint32_t process_id,
+          bool resolve_symbols = false) const {
+    sampling::ResolvedCallStack resolved;
+    convert_into(stack, process_id, resolved, resolve_symbols);
+    return resolved;
+  }
+
+  /** In-place variant of convert(): fills @p resolved without allocating
+   * an intermediate ResolvedCallStack, so batch callers can reuse
+   * pre-sized destination slots. */
+  template <size_t MaxDepth>
+  void convert_into(const sampling::RawCallStack<MaxDepth> &stack,
+                    uint32_t process_id, sampling::ResolvedCallStack &resolved,
+                    bool resolve_symbols = false) const {
+    resolved.frames.clear();
+    resolved.frames.reserve(stack.depth());
+    const sampling::LibraryMap *lm = find_snapshot(process_id);
+    if (lm == nullptr) {
+      for (size_t i = 0; i < stack.depth(); i++) {
+        resolved.frames.emplace_back(sampling::ResolvedFrame{
+            stack.addresses[i], stack.addresses[i], 0, "[unknown]", "", ""});
+      }
+      return;
+    }
+
+    // Consecutive frames usually fall into the same library; remembering
+    // the last matched range turns the common case into two compares
+    // instead of a binary search.
+    const sampling::LibraryRange *last_hit = nullptr;
+    for (size_t i = 0; i < stack.depth(); i++) {
+      uint64_t addr = stack.addresses[i];
+      // find_range avoids materializing resolve()'s temporary
+      // (name, offset) pair; the name is copied once from the stable
+      // range storage.
+      const sampling::LibraryRange *r =
+          (last_hit && addr >= last_hit->start && addr < last_hit->end)
+              ? last_hit
+              : lm->find_range(addr);
+      if (r) {
+        last_hit = r;
+      }
+      if (r) {
+        sampling::ResolvedFrame frame{addr, addr - r->start, 0, r->name, "",
+                                      ""};
+        if (resolve_symbols && symbol_resolver_ != nullptr) {
+          SymbolInfo info =
+              symbol_resolver_->resolve(frame.library_name, frame.offset);
+          frame.function_name = std::move(info.function_name);
+          frame.filename = std::move(info.filename);
+          frame.line_number = info.line_number;
+        }
+        resolved.frames.push_back(std::move(frame));
+      } else {
+        resolved.frames.emplace_back(
+            sampling::ResolvedFrame{addr, addr, 0, "[unknown]", "", ""});
+      }
+    }
+  }
+
+  /** Memoized convert(): results are cached per (process, stack-hash)
+   * key and shared between callers, so recurring stacks - the common
+   * case across files of one rank - skip decoding and symbol
+   * resolution entirely. The cache assumes a consistent
+   * resolve_symbols setting and keys on the stack hash, trading an
+   * astronomically unlikely collision for not storing the raw
+   * addresses. Thread-safe; read-mostly. */
+  template <size_t MaxDepth>
+  std::shared_ptr<const sampling::ResolvedCallStack>
+  convert_cached(const sampling::RawCallStack<MaxDepth> &stack,
+                 uint32_t process_id, bool resolve_symbols = false) const {
+    uint64_t key = sampling::CallStackHash()(stack);
+    key ^= static_cast<uint64_t>(process_id) + 0x9e3779b97f4a7c15ull +
+           (key << 6) + (key >> 2);
+    {
+      std::shared_lock<std::shared_mutex> lock(cache_mutex_);
+      auto it = result_cache_.find(key);
+      if (it != result_cache_.end()) {
+        return it->second;
+      }
+    }
+    auto resolved = std::make_shared<sampling::ResolvedCallStack>();
+    convert_into(stack, process_id, *resolved, resolve_symbols);
+    std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+    return result_cache_.emplace(key, std::move(resolved)).first->second;
+  }
+
+  /** Convert one raw call stack into both flavors at once: the address
+   * decoding (interval search per frame) is done a single time, and only
+   * the symbol-resolution step differs between the two outputs. Useful
+   * for callers that want raw and symbolized views of the same stack.
+   */
+  template <size_t MaxDepth>
+  void convert_dual(const sampling::RawCallStack<MaxDepth> &stack,
+                    uint32_t process_id,
+                    sampling::ResolvedCallStack &out_no_syms,
+                    sampling::ResolvedCallStack &out_with_syms) const {
+    out_no_syms.frames.clear();
+    out_with_syms.frames.clear();
+    out_no_syms.frames.reserve(stack.depth());
+    out_with_syms.frames.reserve(stack.depth());
+
+    const sampling::LibraryMap *lib_map = find_snapshot(process_id);
+
+    const sampling::LibraryRange *last_hit = nullptr;
+    for (size_t i = 0; i < stack.depth(); i++) {
+      uint64_t addr = stack.addresses[i];
+      sampling::ResolvedFrame frame;
+      frame.raw_address = addr;
+      const sampling::LibraryRange *r =
+          (last_hit && addr >= last_hit->start && addr < last_hit->end)
+              ? last_hit
+              : (lib_map ? lib_map->find_range(addr) : nullptr);
+      if (r) {
+        last_hit = r;
+      }
+      if (r) {
+        frame.library_name = r->name;
+        frame.offset = addr - r->start;
+      } else {
+        frame.library_name = "[unknown]";
+        frame.offset = addr;
+      }
+      out_no_syms.frames.push_back(frame);
+      if (r && symbol_resolver_ != nullptr) {
+        SymbolInfo info =
+            symbol_resolver_->resolve(frame.library_name, frame.offset);
+        frame.function_name = std::move(info.function_name);
+        frame.filename = std::move(info.filename);
+        frame.line_number = info.line_number;
+      }
+      out_with_syms.frames.push_back(std::move(frame));
+    }
+  }
+
+  /** Convert a batch of raw call stacks against one process' snapshot.
+   * Stacks are independent and map_snapshots_ is read-only here, so the
+   * batch is data-parallel; snapshots must be frozen (no concurrent
+   * add_map_snapshot) for the duration of the call. */
+  template <size_t MaxDepth>
+  std::vector<sampling::ResolvedCallStack>
+  convert_batch(const std::vector<sampling::RawCallStack<MaxDepth>> &raw_stacks,
+                uint32_t process_id, bool resolve_symbols = false) const {
+    std::vector<sampling::ResolvedCallStack> resolved_stacks;
+    resolved_stacks.resize(raw_stacks.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 64)
+#endif
+    for (size_t i = 0; i < raw_stacks.size(); i++) {
+      convert_into(raw_stacks[i], process_id, resolved_stacks[i],
+                   resolve_symbols);
+    }
+    return resolved_stacks;
+  }
+
+private:
+  using SnapshotVector = std::vector<std::pair<uint32_t, sampling::LibraryMap>>;
+
+  SnapshotVector::iterator snapshot_lower_bound(uint32_t process_id) {
+    return std::lower_bound(map_snapshots_.begin(), map_snapshots_.end(),
+                            process_id,
+                            [](const SnapshotVector::value_type &entry,
+                               uint32_t id) { return entry.first < id; });
+  }
+
+  const sampling::LibraryMap *find_snapshot(uint32_t process_id) const {
+    auto it = std::lower_bound(map_snapshots_.begin(), map_snapshots_.end(),
+                               process_id,
+                               [](const SnapshotVector::value_type &entry,
+                                  uint32_t id) { return entry.first < id; });
+    return it != map_snapshots_.end() && it->first == process_id ? &it->second
+                                                                 : nullptr;
+  }
+
+  /** Sorted by process id. Snapshots arrive in rank order and are never
+   * erased, so a flat sorted vector with lower_bound lookups beats a
+   * node-per-entry map: contiguous probes, no per-insert allocation. */
+  SnapshotVector map_snapshots_;
+  SymbolResolver *symbol_resolver_ = nullptr;
+
+  mutable std::shared_mutex cache_mutex_;
+  mutable std::unordered_map<uint64_t,
+                             std::shared_ptr<const sampling::ResolvedCallStack>>
+      result_cache_;
+};
+
+} // namespace analysis
+} // namespace perflow
+
+#endif
@@ -0,0 +1,238 @@
+#include "perflow/analysis/parallel_file_reader.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <charconv>
+#include <memory>
+
+#include "perflow/sampling/data_importer.h"
+#include "perflow/sampling/static_hash_map.h"
+
+namespace perflow {
+namespace analysis {
+
+namespace {
+
+using SampleMap =
+    sampling::StaticHashMap<sampling::CallStack, sampling::SampleAggregate,
+                            sampling::CallStackHash, sampling::CallStackEqual>;
+
+/** On-disk size of the smallest well-formed record (one frame:
+ * num_frames + address + count + total_time); used to size the
+ * aggregation map from the file size instead of a one-size-fits-all
+ * capacity. */
+constexpr size_t kMinRecordBytes =
+    sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint64_t) + sizeof(double);
+
+/** Progress callbacks fire every this many completed files (and at the
+ * end), keeping the consumer off the per-file critical path. */
+constexpr size_t kProgressInterval = 16;
+
+/** Stage one InsertOp per aggregated stack. The converter presence and
+ * the symbol flag are loop-invariant, so they are template parameters:
+ * each instantiation carries a straight-line inner loop with the
+ * per-stack branches compiled out. */
+template <bool HasConverter, bool ResolveSymbols>
+void collect_ops(const SampleMap &data, const OffsetConverter *converter,
+                 uint32_t process_id, std::vector<InsertOp> &staging) {
+  data.for_each([&](const sampling::CallStack &stack,
+                    const sampling::SampleAggregate &agg) {
+    std::shared_ptr<const std::vector<sampling::ResolvedFrame>> frames;
+    if (HasConverter) {
+      // Memoized and zero-copy: the op aliases the cached frames via
+      // the shared_ptr aliasing constructor, so a recurring stack
+      // costs a refcount bump rather than a frame-by-frame copy into
+      // a fresh vector.
+      auto cached = converter->convert_cached(stack, process_id,
+                                              ResolveSymbols);
+      frames = std::shared_ptr<const std::vector<sampling::ResolvedFrame>>(
+          cached, &cached->frames);
+    } else {
+      // One shared sentinel: copy-assigning from it reuses the SSO
+      // buffer instead of running strlen + construction from a
+      // literal for every frame.
+      static const std::string kUnknown{"[unknown]"};
+      auto owned = std::make_shared<std::vector<sampling::ResolvedFrame>>();
+      owned->reserve(stack.depth());
+      for (size_t i = 0; i < stack.depth(); i++) {
+        owned->emplace_back(sampling::ResolvedFrame{stack.addresses[i],
+                                                    stack.addresses[i], 0,
+                                                    kUnknown, kUnknown, ""});
+      }
+      frames = std::move(owned);
+    }
+    staging.push_back(
+        InsertOp{std::move(frames), process_id, agg.count, agg.total_time});
+  });
+}
+
+/** Per-worker recycled aggregation map. The slot array of a sized
+ * SampleMap is large (each slot embeds a full CallStack), so
+ * reallocating it per file dwarfs the actual decode for small files;
+ * clearing only touches one flag per slot. The map grows to the
+ * largest file its worker has seen and stays with the pool thread. */
+SampleMap &recycled_map(size_t capacity) {
+  thread_local std::unique_ptr<SampleMap> map;
+  if (!map || map->capacity() < capacity) {
+    map = std::make_unique<SampleMap>(capacity);
+  } else {
+    map->clear();
+  }
+  return *map;
+}
+
+size_t estimate_map_capacity(const std::string &filepath) {
+  struct stat st;
+  if (::stat(filepath.c_str(), &st) != 0 || st.st_size <= 0) {
+    return SampleMap::kMinCapacity;
+  }
+  // The minimum record size makes st_size / kMinRecordBytes an upper
+  // bound on the distinct-key count, so the map can never fill even if
+  // every record is unique and one frame deep; 2x headroom keeps the
+  // load factor at or below one half (the map rounds up to the next
+  // power of two itself).
+  return static_cast<size_t>(st.st_size) / kMinRecordBytes * 2;
+}
+
+} // namespace
+
+ParallelFileReader::ParallelFileReader(size_t num_threads)
+    : num_threads_(num_threads == 0 ? 1 : num_threads), pool_(num_threads_) {}
+
+uint32_t
+ParallelFileReader::extract_rank_from_filename(const std::string &path) {
+  // rfind: the rank tag sits near the end of the filename. from_chars
+  // parses in place - no substr allocation, no locale, no exceptions.
+  size_t pos = path.rfind("rank_");
+  if (pos == std::string::npos) {
+    return kInvalidRank;
+  }
+  const char *begin = path.data() + pos + 5;
+  const char *end = path.data() + path.size();
+  uint32_t rank = 0;
+  auto res = std::from_chars(begin, end, rank);
+  return res.ec == std::errc{} && res.ptr != begin ? rank : kInvalidRank;
+}
+
+std::vector<FileReadResult> ParallelFileReader::read_files_parallel(
+    const std::vector<std::string> &sample_files, PerformanceTree &tree,
+    bool resolve_symbols) {
+  size_t total = sample_files.size();
+  std::vector<FileReadResult> results(total);
+  if (total == 0) {
+    return results;
+  }
+  completed_files_.store(0, std::memory_order_relaxed);
+
+  // Trivial batches skip the per-file trees and the merge phase
+  // entirely: with one file or one worker there is nothing to contend
+  // on, so reading straight into the destination halves the memory.
+  if (total == 1 || num_threads_ == 1) {
+    for (size_t i = 0; i < total; i++) {
+      uint32_t rank = extract_rank_from_filename(sample_files[i]);
+      if (rank == kInvalidRank) {
+        rank = static_cast<uint32_t>(i);
+      }
+      results[i] = read_single_file(sample_files[i], rank, tree,
+                                    resolve_symbols);
+      if (progress_callback_) {
+        progress_callback_(i + 1, total);
+      }
+    }
+    return results;
+  }
+
+  // Each file gets a private tree so workers never contend on insert;
+  // the destination is only touched during the final merge.
+  std::vector<std::unique_ptr<PerformanceTree>> per_file_trees(total);
+  for (size_t i = 0; i < total; i++) {
+    per_file_trees[i] = std::make_unique<PerformanceTree>(
+        ConcurrencyMode::kSerial, tree.build_mode(), tree.sample_count_mode());
+  }
+
+  // One task per file on the persistent pool: workers pull files
+  // dynamically, so a few large files do not stall a static partition.
+  // The callback test is hoisted out of the tasks: without a consumer
+  // the workers skip both the erased std::function call and the shared
+  // completion counter (no cache-line ping-pong for nothing).
+  const bool report_progress = static_cast<bool>(progress_callback_);
+  for (size_t i = 0; i < total; i++) {
+    pool_.submit([&, i, total, resolve_symbols, report_progress] {
+      uint32_t rank = extract_rank_from_filename(sample_files[i]);
+      if (rank == kInvalidRank) {
+        rank = static_cast<uint32_t>(i);
+      }
+      results[i] = read_single_file(sample_files[i], rank, *per_file_trees[i],
+                                    resolve_symbols);
+      if (report_progress) {
+        size_t done =
+            completed_files_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (done % kProgressInterval == 0 || done == total) {
+          progress_callback_(done, total);
+        }
+      }
+    });
+  }
+  pool_.wait_all();
+
+  // Pairwise tournament reduction: each round merges disjoint tree
+  // pairs on the pool, so the merge runs in log2(N) rounds instead of
+  // one serial O(N) loop on the caller's thread.
+  for (size_t step = 1; step < total; step *= 2) {
+    for (size_t i = 0; i + step < total; i += 2 * step) {
+      pool_.submit([&per_file_trees, i, step] {
+        merge_tree(*per_file_trees[i], std::move(*per_file_trees[i + step]));
+      });
+    }
+    pool_.wait_all();
+  }
+  merge_tree(tree, std::move(*per_file_trees[0]));
+  return results;
+}
+
+FileReadResult ParallelFileReader::read_single_file(const std::string &filepath,
+                                                    uint32_t process_id,
+                                                    PerformanceTree &tree,
+                                                    bool resolve_symbols) {
+  FileReadResult result;
+  result.filepath = filepath;
+
+  SampleMap &data = recycled_map(estimate_map_capacity(filepath));
+  sampling::DataImporter importer(filepath);
+  if (!importer.importData(data)) {
+    return result;
+  }
+
+  bool has_converter =
+      converter_ != nullptr && converter_->has_snapshot(process_id);
+  // Stage all insertions, then hand the tree one batch: under a locked
+  // concurrency mode the tree synchronizes once per file instead of
+  // once per stack.
+  std::vector<InsertOp> staging;
+  staging.reserve(data.size());
+  if (has_converter) {
+    if (resolve_symbols) {
+      collect_ops<true, true>(data, converter_, process_id, staging);
+    } else {
+      collect_ops<true, false>(data, converter_, process_id, staging);
+    }
+  } else {
+    collect_ops<false, false>(data, converter_, process_id, staging);
+  }
+  tree.insert_call_stacks(staging);
+  result.call_stack_count = staging.size();
+  result.success = true;
+  return result;
+}
+
+void ParallelFileReader::merge_tree(PerformanceTree &dest,
+                                    PerformanceTree &&source) {
+  // absorb_tree grafts disjoint subtrees by moving node pointers rather
+  // than replaying every leaf path through insert_call_stack, so the
+  // merge is linear in the number of unique nodes.
+  dest.absorb_tree(std::move(source));
+}
+
+} // namespace analysis
+} // namespace perflow
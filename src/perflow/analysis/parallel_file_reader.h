@@ -0,0 +1,152 @@
+#ifndef PERFLOW_ANALYSIS_PARALLEL_FILE_READER_H_
+#define PERFLOW_ANALYSIS_PARALLEL_FILE_READER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "perflow/analysis/offset_converter.h"
+#include "perflow/analysis/performance_tree.h"
+
+namespace perflow {
+namespace analysis {
+
+/** Persistent worker pool with a shared task queue. Threads are created
+ * once and pull tasks dynamically, so unequal file sizes do not stall a
+ * statically assigned partition and per-batch thread creation cost is
+ * amortized across the whole run. */
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t num_threads) {
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+      workers_.emplace_back([this] { worker_loop(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    task_ready_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+      in_flight_++;
+    }
+    task_ready_.notify_one();
+  }
+
+  /** Block until every submitted task has finished. */
+  void wait_all() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    all_done_.wait(lock, [this] { return in_flight_ == 0; });
+  }
+
+private:
+  void worker_loop() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        task_ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return; // stopping_ and drained
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_--;
+        if (in_flight_ == 0) {
+          all_done_.notify_all();
+        }
+      }
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable task_ready_;
+  std::condition_variable all_done_;
+  size_t in_flight_ = 0;
+  bool stopping_ = false;
+};
+
+/** Returned by extract_rank_from_filename when no rank is encoded. */
+constexpr uint32_t kInvalidRank = UINT32_MAX;
+
+/** Result of importing one sample file. */
+struct FileReadResult {
+  std::string filepath;
+  bool success = false;
+  size_t call_stack_count = 0; /**<unique call stacks imported */
+};
+
+/** Reads a batch of .pflw sample files on worker threads, converts the
+ * raw stacks via an optional OffsetConverter and aggregates everything
+ * into one PerformanceTree. Each worker builds private per-file trees;
+ * the final merge grafts them into the destination. */
+class ParallelFileReader {
+public:
+  explicit ParallelFileReader(
+      size_t num_threads = std::thread::hardware_concurrency());
+
+  /** Attach the converter used to decode raw addresses. Not owned; may
+   * be null, in which case frames stay "[unknown]". */
+  void set_offset_converter(OffsetConverter *converter) {
+    converter_ = converter;
+  }
+
+  /** Invoked as (files_done, files_total) while reading. */
+  void set_progress_callback(std::function<void(size_t, size_t)> callback) {
+    progress_callback_ = std::move(callback);
+  }
+
+  /** Import all files, aggregating into @p tree. Results are in the
+   * order of @p sample_files. */
+  std::vector<FileReadResult>
+  read_files_parallel(const std::vector<std::string> &sample_files,
+                      PerformanceTree &tree, bool resolve_symbols = false);
+
+  /** Parse the rank id from a "..._rank_<N>.pflw" style filename;
+   * kInvalidRank if absent. */
+  static uint32_t extract_rank_from_filename(const std::string &path);
+
+private:
+  FileReadResult read_single_file(const std::string &filepath,
+                                  uint32_t process_id, PerformanceTree &tree,
+                                  bool resolve_symbols);
+  /** Merge one per-file tree into the destination by grafting. */
+  static void merge_tree(PerformanceTree &dest, PerformanceTree &&source);
+
+  size_t num_threads_;
+  ThreadPool pool_;
+  OffsetConverter *converter_ = nullptr;
+  std::function<void(size_t, size_t)> progress_callback_;
+  std::atomic<size_t> completed_files_{0};
+};
+
+} // namespace analysis
+} // namespace perflow
+
+#endif
@@ -0,0 +1,980 @@
+#include "perflow/analysis/performance_tree.h"
+
+#include <algorithm>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace perflow {
+namespace analysis {
+
+namespace {
+
+/** FNV-1a over a byte range, continuing from @p h. */
+uint64_t fnv1a_append(uint64_t h, const void *data, size_t len) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < len; i++) {
+    h ^= bytes[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+/** 64-bit identity key of a frame: function + library, plus the offset
+ * under the context-aware build mode. */
+uint64_t child_key(const sampling::ResolvedFrame &frame, bool context_aware) {
+  uint64_t h = 14695981039346656037ull;
+  h = fnv1a_append(h, frame.function_name.data(), frame.function_name.size());
+  h = fnv1a_append(h, frame.library_name.data(), frame.library_name.size());
+  if (context_aware) {
+    h = fnv1a_append(h, &frame.offset, sizeof(frame.offset));
+  } else {
+    // Keep the two keyspaces disjoint so a frame's context-free and
+    // context-aware keys never alias each other in child_index_.
+    h ^= 1;
+  }
+  return h;
+}
+
+template <typename Visit> void walk_preorder(const TreeNode &root, Visit &&visit);
+
+/** Preorder predicate collection, parallelized over the independent
+ * top-level subtrees (the sync_atomic_counters pattern). Per-subtree
+ * result vectors keep workers contention-free and are concatenated in
+ * child order, so the output order is deterministic. Only used with
+ * the tree's own predicates, which are known thread-safe; the public
+ * filter_nodes with a caller-supplied functor stays serial. */
+template <typename Pred>
+std::vector<const TreeNode *> collect_matching(const TreeNode &root,
+                                               Pred &&pred) {
+  std::vector<const TreeNode *> out;
+  if (pred(root)) {
+    out.push_back(&root);
+  }
+  const auto &top = root.children();
+#ifdef _OPENMP
+  if (top.size() > 1) {
+    std::vector<std::vector<const TreeNode *>> partial(top.size());
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < top.size(); i++) {
+      walk_preorder(*top[i], [&partial, &pred, i](const TreeNode &node) {
+        if (pred(node)) {
+          partial[i].push_back(&node);
+        }
+      });
+    }
+    // The per-subtree counts are known before concatenation, so the
+    // result vector is sized exactly once instead of re-growing
+    // through the log2(N) doubling sequence while appending.
+    size_t total = out.size();
+    for (const auto &part : partial) {
+      total += part.size();
+    }
+    out.reserve(total);
+    for (const auto &part : partial) {
+      out.insert(out.end(), part.begin(), part.end());
+    }
+    return out;
+  }
+#endif
+  for (const auto &subtree : top) {
+    walk_preorder(*subtree, [&out, &pred](const TreeNode &node) {
+      if (pred(node)) {
+        out.push_back(&node);
+      }
+    });
+  }
+  return out;
+}
+
+/** Iterative preorder walk over a subtree. One explicit work stack
+ * replaces the per-node call frames, so deep trees cannot overflow
+ * the thread stack and the visitor inlines into the loop. */
+template <typename Visit>
+void walk_preorder(const TreeNode &root, Visit &&visit) {
+  std::vector<const TreeNode *> stack;
+  stack.reserve(256);
+  stack.push_back(&root);
+  while (!stack.empty()) {
+    const TreeNode *node = stack.back();
+    stack.pop_back();
+    if (!stack.empty()) {
+      // The next pop is known now; start pulling that node in while
+      // the visitor works on this one.
+      __builtin_prefetch(stack.back());
+    }
+    visit(*node);
+    const auto &children = node->children();
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+      stack.push_back(it->get());
+    }
+  }
+}
+
+/** Preorder walk carrying the node depth; the visitor returns false to
+ * prune the subtree below the node. */
+template <typename Visit>
+void walk_preorder_depth(const TreeNode &root, Visit &&visit) {
+  struct Item {
+    const TreeNode *node;
+    size_t depth;
+  };
+  std::vector<Item> stack;
+  stack.reserve(256);
+  stack.push_back(Item{&root, 0});
+  while (!stack.empty()) {
+    Item item = stack.back();
+    stack.pop_back();
+    if (!stack.empty()) {
+      __builtin_prefetch(stack.back().node);
+    }
+    if (!visit(*item.node, item.depth)) {
+      continue;
+    }
+    const auto &children = item.node->children();
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+      stack.push_back(Item{it->get(), item.depth + 1});
+    }
+  }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// TreeNode
+// ---------------------------------------------------------------------------
+
+TreeNode::TreeNode(const sampling::ResolvedFrame &frame)
+    : frame_(frame), key_context_free_(child_key(frame, false)),
+      key_context_aware_(child_key(frame, true)) {}
+
+std::shared_ptr<TreeNode>
+TreeNode::find_child(const sampling::ResolvedFrame &frame) {
+  auto it = child_index_.find(child_key(frame, false));
+  if (it == child_index_.end()) {
+    return nullptr;
+  }
+  const std::shared_ptr<TreeNode> &child = children_[it->second];
+  if (child->frame_.function_name == frame.function_name &&
+      child->frame_.library_name == frame.library_name) {
+    return child;
+  }
+  // 64-bit hash collision: fall back to the scan.
+  for (const auto &candidate : children_) {
+    if (candidate->frame_.function_name == frame.function_name &&
+        candidate->frame_.library_name == frame.library_name) {
+      return candidate;
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<TreeNode>
+TreeNode::find_child_context_aware(const sampling::ResolvedFrame &frame) {
+  auto it = child_index_.find(child_key(frame, true));
+  if (it == child_index_.end()) {
+    return nullptr;
+  }
+  const std::shared_ptr<TreeNode> &child = children_[it->second];
+  if (child->frame_.function_name == frame.function_name &&
+      child->frame_.library_name == frame.library_name &&
+      child->frame_.offset == frame.offset) {
+    return child;
+  }
+  for (const auto &candidate : children_) {
+    if (candidate->frame_.function_name == frame.function_name &&
+        candidate->frame_.library_name == frame.library_name &&
+        candidate->frame_.offset == frame.offset) {
+      return candidate;
+    }
+  }
+  return nullptr;
+}
+
+void TreeNode::add_child(std::shared_ptr<TreeNode> &&child) {
+  child->parent_ = this;
+  child->depth_ = static_cast<uint16_t>(depth_ + 1);
+  size_t index = children_.size();
+  // emplace keeps the first entry on a key collision; find_child*
+  // verify the frame fields, so the shadowed child is still reachable
+  // through the scan fallback.
+  child_index_.emplace(child->key_context_free_, index);
+  child_index_.emplace(child->key_context_aware_, index);
+  children_.push_back(std::move(child));
+  child_call_counts_.push_back(0);
+}
+
+size_t TreeNode::index_of(const TreeNode *child) const {
+  auto it = child_index_.find(child->key_context_aware_);
+  if (it != child_index_.end() && children_[it->second].get() == child) {
+    return it->second;
+  }
+  // Shadowed by a key collision: fall back to the scan.
+  for (size_t i = 0; i < children_.size(); i++) {
+    if (children_[i].get() == child) {
+      return i;
+    }
+  }
+  return children_.size();
+}
+
+void TreeNode::increment_call_count(TreeNode *child, uint64_t n) {
+  size_t index = index_of(child);
+  if (index < child_call_counts_.size()) {
+    child_call_counts_[index] += n;
+  }
+}
+
+uint64_t TreeNode::call_count(TreeNode *child) const {
+  size_t index = index_of(child);
+  return index < child_call_counts_.size() ? child_call_counts_[index] : 0;
+}
+
+void TreeNode::set_process_count(size_t process_count) {
+  if (sampling_counts_.size() < process_count) {
+    sampling_counts_.resize(process_count, 0);
+    execution_times_.resize(process_count, 0.0);
+  }
+}
+
+void TreeNode::add_sample(uint32_t process_id, uint64_t count, double time,
+                          bool is_leaf) {
+  total_samples_ += count;
+  if (is_leaf) {
+    self_samples_ += count;
+  }
+  // Lazy growth: a node's arrays only ever cover the processes that
+  // actually sampled it, so nodes off a process's paths (e.g. every
+  // interior node under kExclusive) never allocate them at all.
+  if (process_id >= sampling_counts_.size()) {
+    sampling_counts_.resize(process_id + 1, 0);
+    execution_times_.resize(process_id + 1, 0.0);
+  }
+  sampling_counts_[process_id] += count;
+  execution_times_[process_id] += time;
+}
+
+void TreeNode::add_sample_atomic(uint32_t process_id, uint64_t count,
+                                 double time, bool is_leaf,
+                                 StatsDelta &delta) {
+  atomic_total_samples_.fetch_add(count, std::memory_order_relaxed);
+  if (is_leaf) {
+    atomic_self_samples_.fetch_add(count, std::memory_order_relaxed);
+  }
+  // The capacity check happens under the lock: a concurrent tree-wide
+  // set_process_count may be resizing these arrays, so an unlocked
+  // size() read would race with the reallocation.
+  std::lock_guard<SpinLock> lock(node_mutex_);
+  delta.lock_acquisitions++;
+  if (process_id >= sampling_counts_.size()) {
+    sampling_counts_.resize(process_id + 1, 0);
+    execution_times_.resize(process_id + 1, 0.0);
+  }
+  sampling_counts_[process_id] += count;
+  execution_times_[process_id] += time;
+}
+
+void TreeNode::merge_counts(const TreeNode &other) {
+  total_samples_ += other.total_samples_;
+  self_samples_ += other.self_samples_;
+  if (sampling_counts_.size() < other.sampling_counts_.size()) {
+    sampling_counts_.resize(other.sampling_counts_.size(), 0);
+    execution_times_.resize(other.execution_times_.size(), 0.0);
+  }
+  size_t n = other.sampling_counts_.size();
+  uint64_t *counts = sampling_counts_.data();
+  double *times = execution_times_.data();
+  const uint64_t *other_counts = other.sampling_counts_.data();
+  const double *other_times = other.execution_times_.data();
+  size_t pid = 0;
+#ifdef __AVX2__
+  // The per-process arrays are contiguous, so the element-wise add
+  // vectorizes directly: 4 counters / 4 times per iteration.
+  for (; pid + 4 <= n; pid += 4) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(counts + pid),
+        _mm256_add_epi64(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(counts + pid)),
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(other_counts + pid))));
+    _mm256_storeu_pd(times + pid,
+                     _mm256_add_pd(_mm256_loadu_pd(times + pid),
+                                   _mm256_loadu_pd(other_times + pid)));
+  }
+#endif
+  for (; pid < n; pid++) {
+    counts[pid] += other_counts[pid];
+    times[pid] += other_times[pid];
+  }
+}
+
+double TreeNode::total_execution_time() const {
+  const double *times = execution_times_.data();
+  size_t n = execution_times_.size();
+  double total = 0.0;
+  size_t i = 0;
+#ifdef __AVX2__
+  // Wide runs carry one per-process time per rank; sum 4 lanes per
+  // iteration and fold the accumulator once at the end.
+  __m256d acc = _mm256_setzero_pd();
+  for (; i + 4 <= n; i += 4) {
+    acc = _mm256_add_pd(acc, _mm256_loadu_pd(times + i));
+  }
+  __m128d lo = _mm256_castpd256_pd128(acc);
+  __m128d hi = _mm256_extractf128_pd(acc, 1);
+  lo = _mm_add_pd(lo, hi);
+  total = _mm_cvtsd_f64(lo) + _mm_cvtsd_f64(_mm_unpackhi_pd(lo, lo));
+#endif
+  for (; i < n; i++) {
+    total += times[i];
+  }
+  return total;
+}
+
+void TreeNode::sync_atomic_counters() {
+  uint64_t t = atomic_total_samples_.load(std::memory_order_relaxed);
+  uint64_t s = atomic_self_samples_.load(std::memory_order_relaxed);
+  if (t != 0 || s != 0) {
+    total_samples_ += t;
+    self_samples_ += s;
+    atomic_total_samples_.store(0, std::memory_order_relaxed);
+    atomic_self_samples_.store(0, std::memory_order_relaxed);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// PerformanceTree
+// ---------------------------------------------------------------------------
+
+PerformanceTree::PerformanceTree(ConcurrencyMode concurrency_mode,
+                                 TreeBuildMode build_mode,
+                                 SampleCountMode sample_count_mode)
+    : concurrency_mode_(concurrency_mode), build_mode_(build_mode),
+      sample_count_mode_(sample_count_mode) {
+  // One process-wide sentinel frame for the virtual root: built once
+  // instead of per tree, which matters for the per-file and
+  // per-thread trees the reader creates in bulk.
+  static const sampling::ResolvedFrame kRootFrame{0, 0, 0, "[root]", "[root]",
+                                                  ""};
+  root_ = std::make_shared<TreeNode>(kRootFrame);
+}
+
+void PerformanceTree::set_process_count(size_t process_count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (process_count <= process_count_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  process_count_.store(process_count, std::memory_order_relaxed);
+}
+
+void PerformanceTree::insert_call_stack(
+    const std::vector<sampling::ResolvedFrame> &frames, uint32_t process_id,
+    uint64_t count, double time) {
+  if (frames.empty()) {
+    return;
+  }
+  // Double-checked growth: after warmup the relaxed load almost always
+  // passes, so the hot path never touches the tree mutex.
+  if (process_id >= process_count_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (process_id >= process_count_.load(std::memory_order_relaxed)) {
+      process_count_.store(process_id + 1, std::memory_order_relaxed);
+    }
+  }
+  stats_.total_insertions.fetch_add(1, std::memory_order_relaxed);
+
+  switch (concurrency_mode_) {
+  case ConcurrencyMode::kSerial:
+  case ConcurrencyMode::kThreadLocalMerge:
+    insert_serial(frames, process_id, count, time);
+    break;
+  case ConcurrencyMode::kGlobalLock: {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+    insert_serial(frames, process_id, count, time);
+    break;
+  }
+  case ConcurrencyMode::kFineGrainedLock:
+    insert_fine_grained(frames, process_id, count, time);
+    break;
+  case ConcurrencyMode::kLockFree:
+    insert_lock_free(frames, process_id, count, time);
+    break;
+  }
+}
+
+void PerformanceTree::insert_call_stacks(const std::vector<InsertOp> &ops) {
+  if (concurrency_mode_ == ConcurrencyMode::kGlobalLock) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+    for (const InsertOp &op : ops) {
+      if (!op.frames || op.frames->empty()) {
+        continue;
+      }
+      if (op.process_id >= process_count_.load(std::memory_order_relaxed)) {
+        process_count_.store(op.process_id + 1, std::memory_order_relaxed);
+      }
+      stats_.total_insertions.fetch_add(1, std::memory_order_relaxed);
+      insert_serial(*op.frames, op.process_id, op.count, op.time);
+    }
+    return;
+  }
+  for (const InsertOp &op : ops) {
+    if (op.frames) {
+      insert_call_stack(*op.frames, op.process_id, op.count, op.time);
+    }
+  }
+}
+
+template <TreeBuildMode BM, SampleCountMode SM>
+void PerformanceTree::insert_serial_impl(
+    const std::vector<sampling::ResolvedFrame> &frames, uint32_t process_id,
+    uint64_t count, double time) {
+  TreeNode *current = root_.get();
+  // Stacks are leaf first; walk root-wards frames from the back.
+  for (size_t i = frames.size(); i-- > 0;) {
+    const sampling::ResolvedFrame &frame = frames[i];
+    std::shared_ptr<TreeNode> found;
+    if constexpr (BM == TreeBuildMode::kContextAware) {
+      found = current->find_child_context_aware(frame);
+    } else {
+      found = current->find_child(frame);
+    }
+    // Descend by raw pointer: the parent owns the child and nodes are
+    // never removed during a build, so no extra reference is needed.
+    TreeNode *child = found.get();
+    if (child == nullptr) {
+      auto created = std::make_shared<TreeNode>(frame);
+      child = created.get();
+      current->add_child(std::move(created));
+      stats_.nodes_created.fetch_add(1, std::memory_order_relaxed);
+    }
+    current->increment_call_count(child, count);
+
+    bool is_leaf = (i == 0);
+    if constexpr (SM == SampleCountMode::kInclusive) {
+      child->add_sample(process_id, count, time, is_leaf);
+    } else if constexpr (SM == SampleCountMode::kExclusive) {
+      if (is_leaf) {
+        child->add_sample(process_id, count, time, true);
+      }
+    } else {
+      child->add_sample(process_id, count, time, false);
+      if (is_leaf) {
+        child->add_self_sample(count);
+      }
+    }
+    current = child;
+  }
+}
+
+void PerformanceTree::insert_serial(
+    const std::vector<sampling::ResolvedFrame> &frames, uint32_t process_id,
+    uint64_t count, double time) {
+  // Both modes are loop-invariant; dispatch once per stack to a
+  // monomorphic instantiation so the per-frame branches compile out
+  // (the collect_ops<...> pattern in the parallel file reader).
+  if (build_mode_ == TreeBuildMode::kContextAware) {
+    switch (sample_count_mode_) {
+    case SampleCountMode::kInclusive:
+      insert_serial_impl<TreeBuildMode::kContextAware,
+                         SampleCountMode::kInclusive>(frames, process_id,
+                                                      count, time);
+      break;
+    case SampleCountMode::kExclusive:
+      insert_serial_impl<TreeBuildMode::kContextAware,
+                         SampleCountMode::kExclusive>(frames, process_id,
+                                                      count, time);
+      break;
+    case SampleCountMode::kBoth:
+      insert_serial_impl<TreeBuildMode::kContextAware, SampleCountMode::kBoth>(
+          frames, process_id, count, time);
+      break;
+    }
+    return;
+  }
+  switch (sample_count_mode_) {
+  case SampleCountMode::kInclusive:
+    insert_serial_impl<TreeBuildMode::kContextFree,
+                       SampleCountMode::kInclusive>(frames, process_id, count,
+                                                    time);
+    break;
+  case SampleCountMode::kExclusive:
+    insert_serial_impl<TreeBuildMode::kContextFree,
+                       SampleCountMode::kExclusive>(frames, process_id, count,
+                                                    time);
+    break;
+  case SampleCountMode::kBoth:
+    insert_serial_impl<TreeBuildMode::kContextFree, SampleCountMode::kBoth>(
+        frames, process_id, count, time);
+    break;
+  }
+}
+
+void PerformanceTree::flush_stats_delta(const StatsDelta &delta) {
+  if (delta.lock_acquisitions != 0) {
+    stats_.lock_acquisitions.fetch_add(delta.lock_acquisitions,
+                                       std::memory_order_relaxed);
+  }
+  if (delta.cas_retries != 0) {
+    stats_.cas_retries.fetch_add(delta.cas_retries,
+                                 std::memory_order_relaxed);
+  }
+  if (delta.nodes_created != 0) {
+    stats_.nodes_created.fetch_add(delta.nodes_created,
+                                   std::memory_order_relaxed);
+  }
+}
+
+void PerformanceTree::insert_fine_grained(
+    const std::vector<sampling::ResolvedFrame> &frames, uint32_t process_id,
+    uint64_t count, double time) {
+  TreeNode *current = root_.get();
+  // Stats deltas are batched locally and flushed once per stack, so
+  // the shared stats cache line is touched once per insert instead of
+  // twice per frame.
+  StatsDelta delta;
+  for (size_t i = frames.size(); i-- > 0;) {
+    const sampling::ResolvedFrame &frame = frames[i];
+    std::unique_lock<SpinLock> lock(current->node_mutex_);
+    delta.lock_acquisitions++;
+    std::shared_ptr<TreeNode> found =
+        build_mode_ == TreeBuildMode::kContextAware
+            ? current->find_child_context_aware(frame)
+            : current->find_child(frame);
+    // The parent keeps the child alive past the unlock - nodes are
+    // never removed during a build - so the descent holds no
+    // reference of its own.
+    TreeNode *child = found.get();
+    if (child == nullptr) {
+      auto created = std::make_shared<TreeNode>(frame);
+      child = created.get();
+      current->add_child(std::move(created));
+      delta.nodes_created++;
+    }
+    current->increment_call_count(child, count);
+    lock.unlock();
+
+    bool is_leaf = (i == 0);
+    std::lock_guard<SpinLock> child_lock(child->node_mutex_);
+    delta.lock_acquisitions++;
+    // Same semantics as insert_serial_impl in every mode: the sample
+    // counts as self exactly at the leaf.
+    if (sample_count_mode_ != SampleCountMode::kExclusive || is_leaf) {
+      child->add_sample(process_id, count, time, is_leaf);
+    }
+    current = child;
+  }
+  flush_stats_delta(delta);
+}
+
+void PerformanceTree::insert_lock_free(
+    const std::vector<sampling::ResolvedFrame> &frames, uint32_t process_id,
+    uint64_t count, double time) {
+  TreeNode *current = root_.get();
+  StatsDelta delta;
+  for (size_t i = frames.size(); i-- > 0;) {
+    const sampling::ResolvedFrame &frame = frames[i];
+    TreeNode *child = nullptr;
+    {
+      std::lock_guard<SpinLock> lock(current->node_mutex_);
+      delta.lock_acquisitions++;
+      std::shared_ptr<TreeNode> found =
+          build_mode_ == TreeBuildMode::kContextAware
+              ? current->find_child_context_aware(frame)
+              : current->find_child(frame);
+      child = found.get();
+      if (child == nullptr) {
+        auto created = std::make_shared<TreeNode>(frame);
+        child = created.get();
+        current->add_child(std::move(created));
+        delta.nodes_created++;
+      }
+      current->increment_call_count(child, count);
+    }
+    bool is_leaf = (i == 0);
+    // Leaf samples count as self in every mode, matching the serial
+    // path.
+    if (sample_count_mode_ != SampleCountMode::kExclusive || is_leaf) {
+      child->add_sample_atomic(process_id, count, time, is_leaf, delta);
+    }
+    current = child;
+  }
+  flush_stats_delta(delta);
+}
+
+size_t PerformanceTree::count_nodes() const {
+  size_t count = 0;
+  walk_preorder(*root_, [&count](const TreeNode &) { count++; });
+  return count - 1; // exclude the virtual root
+}
+
+size_t PerformanceTree::max_depth() const {
+  size_t max = 0;
+  walk_preorder_depth(*root_, [&max](const TreeNode &, size_t depth) {
+    max = std::max(max, depth);
+    return true;
+  });
+  return max;
+}
+
+PerformanceTree::TreeStats PerformanceTree::compute_stats() const {
+  TreeStats stats;
+  walk_preorder_depth(*root_,
+                      [&stats](const TreeNode &node, size_t depth) {
+                        stats.node_count++;
+                        stats.max_depth = std::max(stats.max_depth, depth);
+                        if (node.children().empty()) {
+                          stats.leaves.push_back(&node);
+                        }
+                        return true;
+                      });
+  stats.node_count--; // exclude the virtual root
+  return stats;
+}
+
+void PerformanceTree::traverse_preorder(
+    const std::function<void(const TreeNode &)> &visit) const {
+  walk_preorder(*root_, visit);
+}
+
+void PerformanceTree::traverse_postorder(
+    const std::function<void(const TreeNode &)> &visit) const {
+  // Iterative postorder: each stack entry tracks how many of its
+  // children have been expanded; a node is visited once the index has
+  // run past its last child.
+  struct Item {
+    const TreeNode *node;
+    size_t next_child;
+  };
+  std::vector<Item> stack;
+  stack.reserve(256);
+  stack.push_back(Item{root_.get(), 0});
+  while (!stack.empty()) {
+    Item &item = stack.back();
+    const auto &children = item.node->children();
+    if (item.next_child < children.size()) {
+      const TreeNode *child = children[item.next_child++].get();
+      stack.push_back(Item{child, 0});
+    } else {
+      visit(*item.node);
+      stack.pop_back();
+    }
+  }
+}
+
+void PerformanceTree::traverse_levelorder(
+    const std::function<void(const TreeNode &)> &visit) const {
+  // Two level buffers swapped per level instead of a deque: the deque
+  // allocates and frees fixed-size chunks as the frontier moves, while
+  // the vectors grow to the widest level once and are reused for the
+  // rest of the walk. Raw pointers - the tree is alive throughout, so
+  // no shared_ptr refcounts are bumped.
+  std::vector<const TreeNode *> current;
+  std::vector<const TreeNode *> next;
+  current.push_back(root_.get());
+  while (!current.empty()) {
+    next.clear();
+    for (size_t i = 0; i < current.size(); i++) {
+      if (i + 1 < current.size()) {
+        // Pull the next node's child array towards the cache while the
+        // callback runs; BFS order makes the next visit predictable.
+        __builtin_prefetch(current[i + 1]->children().data());
+      }
+      visit(*current[i]);
+      for (const auto &child : current[i]->children()) {
+        next.push_back(child.get());
+      }
+    }
+    std::swap(current, next);
+  }
+}
+
+std::vector<const TreeNode *> PerformanceTree::collect_leaf_nodes() const {
+  std::vector<const TreeNode *> out;
+  // nodes_created tracks how many nodes this tree built; roughly half
+  // of a calling-context tree is leaves, so reserving that up front
+  // absorbs the log-N grow-copy sequence on large trees.
+  out.reserve(stats_.nodes_created.load(std::memory_order_relaxed) / 2 + 16);
+  walk_preorder(*root_, [&out](const TreeNode &node) {
+    if (node.children().empty()) {
+      out.push_back(&node);
+    }
+  });
+  return out;
+}
+
+std::vector<const TreeNode *>
+PerformanceTree::find_nodes_by_name(const std::string &function_name) const {
+  return collect_matching(*root_, [&function_name](const TreeNode &node) {
+    return node.frame().function_name == function_name;
+  });
+}
+
+std::vector<const TreeNode *>
+PerformanceTree::find_nodes_by_library(const std::string &library_name) const {
+  return collect_matching(*root_, [&library_name](const TreeNode &node) {
+    return node.frame().library_name == library_name;
+  });
+}
+
+std::vector<const TreeNode *>
+PerformanceTree::collect_nodes_at_depth(size_t depth) const {
+  std::vector<const TreeNode *> out;
+  walk_preorder_depth(
+      *root_, [&out, depth](const TreeNode &node, size_t node_depth) {
+        if (node_depth == depth) {
+          out.push_back(&node);
+          return false; // nothing below can match; prune
+        }
+        return true;
+      });
+  return out;
+}
+
+std::vector<const TreeNode *> PerformanceTree::filter_nodes(
+    const std::function<bool(const TreeNode &)> &accept) const {
+  std::vector<const TreeNode *> out;
+  walk_preorder(*root_, [&out, &accept](const TreeNode &node) {
+    if (accept(node)) {
+      out.push_back(&node);
+    }
+  });
+  return out;
+}
+
+std::vector<std::vector<const TreeNode *>> PerformanceTree::filter_nodes_multi(
+    const std::vector<std::function<bool(const TreeNode &)>> &accepts) const {
+  std::vector<std::vector<const TreeNode *>> out(accepts.size());
+  if (accepts.empty()) {
+    return out;
+  }
+  walk_preorder(*root_, [&out, &accepts](const TreeNode &node) {
+    for (size_t i = 0; i < accepts.size(); i++) {
+      if (accepts[i](node)) {
+        out[i].push_back(&node);
+      }
+    }
+  });
+  return out;
+}
+
+std::vector<const TreeNode *>
+PerformanceTree::filter_by_samples(uint64_t min_samples) const {
+  return collect_matching(*root_, [min_samples](const TreeNode &node) {
+    return node.total_samples() >= min_samples;
+  });
+}
+
+std::vector<const TreeNode *>
+PerformanceTree::filter_by_self_samples(uint64_t min_samples) const {
+  return collect_matching(*root_, [min_samples](const TreeNode &node) {
+    return node.self_samples() >= min_samples;
+  });
+}
+
+PerformanceTree::FlatTree PerformanceTree::flatten() const {
+  FlatTree flat;
+  flat.nodes.reserve(stats_.nodes_created.load(std::memory_order_relaxed) + 1);
+  flat.nodes.push_back(FlatNode{root_.get(), 0, 0, 0});
+  // The vector doubles as the work queue: entry i is finalized while
+  // its children are appended as one contiguous block. Indexed access
+  // throughout - push_back invalidates references into the vector.
+  for (size_t i = 0; i < flat.nodes.size(); i++) {
+    const TreeNode *node = flat.nodes[i].node;
+    uint16_t child_depth = static_cast<uint16_t>(flat.nodes[i].depth + 1);
+    flat.nodes[i].first_child = static_cast<uint32_t>(flat.nodes.size());
+    flat.nodes[i].child_count = static_cast<uint32_t>(node->children().size());
+    for (const auto &child : node->children()) {
+      flat.nodes.push_back(FlatNode{child.get(), 0, 0, child_depth});
+    }
+  }
+  return flat;
+}
+
+void PerformanceTree::merge_tree(const PerformanceTree &other) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+  process_count_.store(std::max(process_count_.load(std::memory_order_relaxed),
+                                other.process_count_.load(
+                                    std::memory_order_relaxed)),
+                       std::memory_order_relaxed);
+
+  // Phase 1 (serial, cheap): match or create the top-level children.
+  // Distinct top-level frames land in distinct subtrees of root_, so
+  // everything below this level is disjoint work.
+  std::vector<std::pair<TreeNode *, const TreeNode *>> pairs;
+  pairs.reserve(other.root_->children().size());
+  for (const auto &src_child : other.root_->children()) {
+    std::shared_ptr<TreeNode> found =
+        build_mode_ == TreeBuildMode::kContextAware
+            ? root_->find_child_context_aware(src_child->frame())
+            : root_->find_child(src_child->frame());
+    TreeNode *node = found.get();
+    if (node == nullptr) {
+      auto created = std::make_shared<TreeNode>(src_child->frame());
+      node = created.get();
+      root_->add_child(std::move(created));
+      stats_.nodes_created.fetch_add(1, std::memory_order_relaxed);
+    }
+    node->set_process_count(process_count_.load(std::memory_order_relaxed));
+    node->merge_counts(*src_child);
+    root_->increment_call_count(node, src_child->total_samples());
+    pairs.emplace_back(node, src_child.get());
+  }
+
+  // Phase 2: merge the subtrees. Thread-local aggregation is the case
+  // where the post-phase merge dominates, so for kThreadLocalMerge the
+  // disjoint pairs are striped across threads; no locking is needed
+  // because no two pairs touch the same destination subtree (stats_
+  // counters are atomic).
+  size_t num_threads = 1;
+  if (concurrency_mode_ == ConcurrencyMode::kThreadLocalMerge &&
+      pairs.size() > 1) {
+    num_threads = std::min<size_t>(
+        {pairs.size(), std::thread::hardware_concurrency(), 16});
+  }
+  if (num_threads <= 1) {
+    for (const auto &pair : pairs) {
+      merge_subtree(*pair.first, *pair.second);
+    }
+    return;
+  }
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads);
+  for (size_t t = 0; t < num_threads; t++) {
+    workers.emplace_back([this, &pairs, t, num_threads] {
+      for (size_t i = t; i < pairs.size(); i += num_threads) {
+        merge_subtree(*pairs[i].first, *pairs[i].second);
+      }
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+void PerformanceTree::merge_subtree(TreeNode &dest, const TreeNode &src) {
+  // Iterative DFS instead of one call frame per source node. No path
+  // is tracked: nothing on the merge path needs the frames, and the
+  // trace below reads the depth cached on the source node.
+  struct MergeItem {
+    TreeNode *parent;
+    const TreeNode *src;
+  };
+  std::vector<MergeItem> worklist;
+  for (auto it = src.children().rbegin(); it != src.children().rend(); ++it) {
+    worklist.push_back(MergeItem{&dest, it->get()});
+  }
+
+  while (!worklist.empty()) {
+    MergeItem item = worklist.back();
+    worklist.pop_back();
+
+    std::shared_ptr<TreeNode> found =
+        build_mode_ == TreeBuildMode::kContextAware
+            ? item.parent->find_child_context_aware(item.src->frame())
+            : item.parent->find_child(item.src->frame());
+    TreeNode *node = found.get();
+    if (node == nullptr) {
+      auto created = std::make_shared<TreeNode>(item.src->frame());
+      node = created.get();
+      item.parent->add_child(std::move(created));
+      stats_.nodes_created.fetch_add(1, std::memory_order_relaxed);
+    }
+    node->set_process_count(process_count_.load(std::memory_order_relaxed));
+    node->merge_counts(*item.src);
+    item.parent->increment_call_count(node, item.src->total_samples());
+
+#ifdef PERFLOW_MERGE_TRACE
+    fprintf(stderr, "[merge] depth=%zu %s\n", item.src->depth(),
+            item.src->frame().function_name.c_str());
+#endif
+
+    for (auto it = item.src->children().rbegin();
+         it != item.src->children().rend(); ++it) {
+      worklist.push_back(MergeItem{node, it->get()});
+    }
+  }
+}
+
+void PerformanceTree::absorb_tree(PerformanceTree &&other) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.lock_acquisitions.fetch_add(1, std::memory_order_relaxed);
+  process_count_.store(std::max(process_count_.load(std::memory_order_relaxed),
+                                other.process_count_.load(
+                                    std::memory_order_relaxed)),
+                       std::memory_order_relaxed);
+  absorb_node(*root_, *other.root_);
+}
+
+void PerformanceTree::absorb_node(TreeNode &dest_root, TreeNode &src_root) {
+  // Iterative worklist instead of one call frame per overlapping node.
+  // Source nodes keep ownership of matched children until the whole
+  // walk is done; the deferred cleanup then releases every processed
+  // source node in one pass.
+  std::vector<std::pair<TreeNode *, TreeNode *>> worklist;
+  std::vector<TreeNode *> processed;
+  worklist.emplace_back(&dest_root, &src_root);
+  while (!worklist.empty()) {
+    TreeNode *dest = worklist.back().first;
+    TreeNode *src = worklist.back().second;
+    worklist.pop_back();
+    for (auto &child : src->children_) {
+      uint64_t edge = src->call_count(child.get());
+      std::shared_ptr<TreeNode> match =
+          build_mode_ == TreeBuildMode::kContextAware
+              ? dest->find_child_context_aware(child->frame_)
+              : dest->find_child(child->frame_);
+      if (!match) {
+        // Disjoint subtree: graft the node pointer instead of
+        // replaying its leaves through insert_call_stack. Descendant
+        // parent pointers, child indices and edge weights stay valid
+        // because the nodes themselves do not move.
+        dest->add_child(std::move(child));
+        dest->child_call_counts_.back() += edge;
+      } else {
+        match->merge_counts(*child);
+        dest->increment_call_count(match.get(), edge);
+        worklist.emplace_back(match.get(), child.get());
+      }
+    }
+    processed.push_back(src);
+  }
+  // Release in reverse (children before parents): clearing a parent's
+  // children_ destroys its matched child nodes, so those children must
+  // have been emptied first.
+  for (auto it = processed.rbegin(); it != processed.rend(); ++it) {
+    (*it)->children_.clear();
+    (*it)->child_call_counts_.clear();
+    (*it)->child_index_.clear();
+  }
+}
+
+void PerformanceTree::sync_atomic_counters() {
+  root_->sync_atomic_counters();
+  // Subtrees under root are independent, so folding them is
+  // embarrassingly parallel; each iteration walks one top-level
+  // subtree with its own stack.
+  const auto &top = root_->children_;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (size_t i = 0; i < top.size(); i++) {
+    std::vector<TreeNode *> stack;
+    stack.push_back(top[i].get());
+    while (!stack.empty()) {
+      TreeNode *node = stack.back();
+      stack.pop_back();
+      node->sync_atomic_counters();
+      for (const auto &child : node->children_) {
+        stack.push_back(child.get());
+      }
+    }
+  }
+}
+
+} // namespace analysis
+} // namespace perflow
@@ -0,0 +1,348 @@
+#ifndef PERFLOW_ANALYSIS_PERFORMANCE_TREE_H_
+#define PERFLOW_ANALYSIS_PERFORMANCE_TREE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "perflow/sampling/call_stack.h"
+
+namespace perflow {
+namespace analysis {
+
+/** How concurrent inserts into the tree are synchronized. */
+enum class ConcurrencyMode {
+  kSerial,           /**<single-threaded build, no locking */
+  kGlobalLock,       /**<one tree-wide mutex per insert */
+  kFineGrainedLock,  /**<per-node mutexes taken while descending */
+  kLockFree,         /**<atomic sample counters, locks only for structure */
+  kThreadLocalMerge, /**<thread-local trees merged post-build */
+};
+
+/** How frames are keyed when matching children during insertion. */
+enum class TreeBuildMode {
+  kContextFree,  /**<match on (function, library) */
+  kContextAware, /**<additionally match on the exact offset */
+};
+
+/** Which counters a sample contributes to along its call path. */
+enum class SampleCountMode {
+  kInclusive, /**<every node on the path */
+  kExclusive, /**<only the leaf */
+  kBoth,      /**<inclusive on the path, exclusive at the leaf */
+};
+
+/** 1-byte test-and-test-and-set spinlock for per-node synchronization.
+ * Node critical sections are a few loads and stores, so spinning beats
+ * parking, and one byte instead of a 40-byte std::mutex keeps millions
+ * of nodes compact. Meets BasicLockable, so std::lock_guard /
+ * std::unique_lock work unchanged. */
+class SpinLock {
+public:
+  void lock() {
+    while (true) {
+      // Spin on a relaxed read and only attempt the exchange when the
+      // lock looks free, so waiters do not ping the cache line.
+      if (flag_.load(std::memory_order_relaxed) == 0 &&
+          flag_.exchange(1, std::memory_order_acquire) == 0) {
+        return;
+      }
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+  }
+
+  void unlock() { flag_.store(0, std::memory_order_release); }
+
+private:
+  std::atomic<uint8_t> flag_{0};
+};
+
+/** Counters describing synchronization behavior during a build. Each
+ * counter sits on its own cache line so threads bumping different
+ * counters do not false-share one line. */
+struct ConcurrencyStats {
+  alignas(64) std::atomic<uint64_t> total_insertions{0};
+  alignas(64) std::atomic<uint64_t> lock_acquisitions{0};
+  alignas(64) std::atomic<uint64_t> cas_retries{0};
+  alignas(64) std::atomic<uint64_t> nodes_created{0};
+};
+
+/** Plain per-call-stack scratch for stats deltas. The concurrent
+ * insert paths accumulate here and flush to the shared atomic
+ * ConcurrencyStats once per stack, so the stats cache line is hit
+ * once per insert instead of several times per frame. */
+struct StatsDelta {
+  uint64_t lock_acquisitions = 0;
+  uint64_t cas_retries = 0;
+  uint64_t nodes_created = 0;
+};
+
+/** One node of a performance tree: a resolved frame plus per-process
+ * sample counters and edge weights towards its children. */
+class TreeNode {
+public:
+  explicit TreeNode(const sampling::ResolvedFrame &frame);
+
+  const sampling::ResolvedFrame &frame() const { return frame_; }
+  TreeNode *parent() const { return parent_; }
+  const std::vector<std::shared_ptr<TreeNode>> &children() const {
+    return children_;
+  }
+
+  /** Hash lookup for the child matching a frame (context-free key:
+   * function + library). */
+  std::shared_ptr<TreeNode> find_child(const sampling::ResolvedFrame &frame);
+  /** Hash lookup matching (function, library, offset). */
+  std::shared_ptr<TreeNode>
+  find_child_context_aware(const sampling::ResolvedFrame &frame);
+
+  /** Adopt a child; sink parameter, so creation sites hand over their
+   * reference instead of paying a refcount round-trip per node. */
+  void add_child(std::shared_ptr<TreeNode> &&child);
+
+  /** Bump the edge weight towards a child. */
+  void increment_call_count(TreeNode *child, uint64_t n);
+  uint64_t call_count(TreeNode *child) const;
+
+  /** Grow per-process counter arrays to hold process_count entries.
+   * Optional pre-sizing; add_sample grows the arrays lazily, so nodes
+   * only allocate them once a process actually samples them. */
+  void set_process_count(size_t process_count);
+
+  /** Record count samples / time for a process on this node, growing
+   * the per-process arrays on demand. */
+  void add_sample(uint32_t process_id, uint64_t count, double time,
+                  bool is_leaf);
+  /** Bump only the exclusive (self) counter. */
+  void add_self_sample(uint64_t count) { self_samples_ += count; }
+  /** Same, but via atomic counters (lock-free builds). */
+  void add_sample_atomic(uint32_t process_id, uint64_t count, double time,
+                         bool is_leaf, StatsDelta &delta);
+
+  uint64_t total_samples() const { return total_samples_; }
+  uint64_t self_samples() const { return self_samples_; }
+  const std::vector<uint64_t> &sampling_counts() const {
+    return sampling_counts_;
+  }
+  const std::vector<double> &execution_times() const {
+    return execution_times_;
+  }
+
+  /** Sum of per-process execution times. */
+  double total_execution_time() const;
+
+  /** Additively fold another node's counters into this node, growing
+   * the per-process arrays as needed. */
+  void merge_counts(const TreeNode &other);
+
+  /** Distance from the root; cached at insertion, O(1). */
+  size_t depth() const { return depth_; }
+
+  /** Fold atomic counters back into the plain ones after a lock-free
+   * build. */
+  void sync_atomic_counters();
+
+private:
+  friend class PerformanceTree;
+
+  /** Index of @p child in children_; O(1) via the child index. */
+  size_t index_of(const TreeNode *child) const;
+
+  sampling::ResolvedFrame frame_;
+  /** The node's context-free / context-aware identity keys, hashed
+   * once at construction. frame_ is immutable afterwards, so add_child
+   * and index_of reuse these instead of rehashing the frame's strings
+   * on every edge-weight bump. */
+  uint64_t key_context_free_ = 0;
+  uint64_t key_context_aware_ = 0;
+  TreeNode *parent_ = nullptr;
+  /** Set by add_child from the parent's depth; fits in padding. */
+  uint16_t depth_ = 0;
+  std::vector<std::shared_ptr<TreeNode>> children_;
+  /** children_ indices keyed by a 64-bit hash of the frame's identity,
+   * indexed under both the context-free and the context-aware key.
+   * A hit is verified against the actual frame fields, so a (rare)
+   * hash collision degrades to the old linear scan instead of
+   * returning the wrong child. */
+  std::unordered_map<uint64_t, size_t> child_index_;
+  /** Edge weight towards children_[i]; indexed identically to
+   * children_, so bumping an edge is one vector store instead of a
+   * hash-map probe per frame. */
+  std::vector<uint64_t> child_call_counts_;
+
+  uint64_t total_samples_ = 0;
+  uint64_t self_samples_ = 0;
+  std::atomic<uint64_t> atomic_total_samples_{0};
+  std::atomic<uint64_t> atomic_self_samples_{0};
+
+  /** Per-process counters; execution time lives only here (summed by
+   * total_execution_time), updated under node_mutex_ even on the
+   * lock-free path because the array may be resizing. */
+  std::vector<uint64_t> sampling_counts_; /**<per-process sample counts */
+  std::vector<double> execution_times_;   /**<per-process execution time */
+
+  SpinLock node_mutex_;
+};
+
+/** One staged call-stack insertion for the batch API. The frames are
+ * shared, not owned: ops staged from the conversion cache alias the
+ * cached vector directly, so staging a recurring stack costs a
+ * refcount bump instead of a frame-by-frame copy. */
+struct InsertOp {
+  std::shared_ptr<const std::vector<sampling::ResolvedFrame>>
+      frames; /**<leaf first */
+  uint32_t process_id = 0;
+  uint64_t count = 1;
+  double time = 0.0;
+};
+
+/** A calling-context tree aggregated from resolved call stacks. */
+class PerformanceTree {
+public:
+  explicit PerformanceTree(
+      ConcurrencyMode concurrency_mode = ConcurrencyMode::kSerial,
+      TreeBuildMode build_mode = TreeBuildMode::kContextFree,
+      SampleCountMode sample_count_mode = SampleCountMode::kInclusive);
+
+  /** Insert one resolved call stack (leaf first) for a process. */
+  void insert_call_stack(const std::vector<sampling::ResolvedFrame> &frames,
+                         uint32_t process_id, uint64_t count = 1,
+                         double time = 0.0);
+
+  /** Insert a staged batch. Under kGlobalLock the tree mutex is taken
+   * once for the whole batch instead of once per stack. */
+  void insert_call_stacks(const std::vector<InsertOp> &ops);
+
+  std::shared_ptr<TreeNode> root() const { return root_; }
+  ConcurrencyMode concurrency_mode() const { return concurrency_mode_; }
+  TreeBuildMode build_mode() const { return build_mode_; }
+  SampleCountMode sample_count_mode() const { return sample_count_mode_; }
+  size_t process_count() const {
+    return process_count_.load(std::memory_order_relaxed);
+  }
+  const ConcurrencyStats &stats() const { return stats_; }
+
+  /** Ensure counter arrays on all nodes cover process_count processes. */
+  void set_process_count(size_t process_count);
+
+  size_t count_nodes() const;
+  size_t max_depth() const;
+
+  /** Node count, depth and leaves gathered in one walk; use this when
+   * more than one summary is needed so the tree is traversed once
+   * instead of once per query. */
+  struct TreeStats {
+    size_t node_count = 0; /**<excludes the virtual root */
+    size_t max_depth = 0;
+    std::vector<const TreeNode *> leaves;
+  };
+  TreeStats compute_stats() const;
+
+  /** One entry of a flattened tree; children occupy the contiguous
+   * index range [first_child, first_child + child_count). */
+  struct FlatNode {
+    const TreeNode *node = nullptr;
+    uint32_t first_child = 0;
+    uint32_t child_count = 0;
+    uint16_t depth = 0;
+  };
+  /** Immutable index-linked snapshot of the tree in level order, with
+   * each node's children laid out contiguously. Reporting code that
+   * re-walks a frozen tree many times can sweep this array
+   * sequentially instead of chasing shared_ptrs; entries borrow the
+   * live nodes, so the snapshot is valid only while the tree is not
+   * mutated. */
+  struct FlatTree {
+    std::vector<FlatNode> nodes; /**<nodes[0] is the virtual root */
+
+    /** Node count excluding the virtual root; O(1). */
+    size_t node_count() const { return nodes.empty() ? 0 : nodes.size() - 1; }
+    /** Maximum node depth. Level order keeps depths non-decreasing,
+     * so the answer is the last entry's depth - no reduction over the
+     * array is needed at all. */
+    size_t max_depth() const { return nodes.empty() ? 0 : nodes.back().depth; }
+  };
+  FlatTree flatten() const;
+
+  void traverse_preorder(const std::function<void(const TreeNode &)> &visit) const;
+  void traverse_postorder(const std::function<void(const TreeNode &)> &visit) const;
+  void traverse_levelorder(const std::function<void(const TreeNode &)> &visit) const;
+
+  std::vector<const TreeNode *> collect_leaf_nodes() const;
+  std::vector<const TreeNode *>
+  find_nodes_by_name(const std::string &function_name) const;
+  std::vector<const TreeNode *>
+  find_nodes_by_library(const std::string &library_name) const;
+  std::vector<const TreeNode *> collect_nodes_at_depth(size_t depth) const;
+  std::vector<const TreeNode *>
+  filter_nodes(const std::function<bool(const TreeNode &)> &accept) const;
+  /** Evaluate several predicates in one walk. Returns one result
+   * vector per predicate, in order; K stacked filters cost one
+   * traversal of the tree instead of K cache-cold passes. */
+  std::vector<std::vector<const TreeNode *>> filter_nodes_multi(
+      const std::vector<std::function<bool(const TreeNode &)>> &accepts) const;
+  std::vector<const TreeNode *> filter_by_samples(uint64_t min_samples) const;
+  std::vector<const TreeNode *>
+  filter_by_self_samples(uint64_t min_samples) const;
+
+  /** Merge another tree (e.g. a thread-local one) into this tree.
+   * Under kThreadLocalMerge the disjoint top-level subtrees are merged
+   * on multiple threads, so the post-build merge phase scales with
+   * cores instead of serializing on one. */
+  void merge_tree(const PerformanceTree &other);
+
+  /** Destructive merge: subtrees absent from this tree are grafted by
+   * moving the node pointers out of @p other instead of being rebuilt
+   * node by node; overlapping nodes fold their counters additively.
+   * O(unique nodes); @p other is left empty. */
+  void absorb_tree(PerformanceTree &&other);
+
+  /** Fold atomic counters into the plain ones on every node. */
+  void sync_atomic_counters();
+
+private:
+  void insert_serial(const std::vector<sampling::ResolvedFrame> &frames,
+                     uint32_t process_id, uint64_t count, double time);
+  /** Monomorphic serial insert: the build and count modes are template
+   * parameters so the per-frame mode branches compile out; dispatched
+   * once per stack by insert_serial. */
+  template <TreeBuildMode BM, SampleCountMode SM>
+  void insert_serial_impl(const std::vector<sampling::ResolvedFrame> &frames,
+                          uint32_t process_id, uint64_t count, double time);
+  void insert_fine_grained(const std::vector<sampling::ResolvedFrame> &frames,
+                           uint32_t process_id, uint64_t count, double time);
+  void insert_lock_free(const std::vector<sampling::ResolvedFrame> &frames,
+                        uint32_t process_id, uint64_t count, double time);
+
+  /** Apply a batch of per-stack stats deltas to the shared counters. */
+  void flush_stats_delta(const StatsDelta &delta);
+
+  /** Merge src's descendants into dest (one disjoint subtree pair). */
+  void merge_subtree(TreeNode &dest, const TreeNode &src);
+
+  void absorb_node(TreeNode &dest, TreeNode &src);
+
+
+  std::shared_ptr<TreeNode> root_;
+  ConcurrencyMode concurrency_mode_;
+  TreeBuildMode build_mode_;
+  SampleCountMode sample_count_mode_;
+  /** Atomic so the insert hot path can check it with a relaxed load;
+   * growth is double-checked under mutex_. */
+  std::atomic<size_t> process_count_{0};
+  ConcurrencyStats stats_;
+  mutable std::mutex mutex_;
+};
+
+} // namespace analysis
+} // namespace perflow
+
+#endif
@@ -0,0 +1,190 @@
+#include "perflow/analysis/symbol_resolver.h"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstdio>
+
+extern char **environ;
+
+namespace perflow {
+namespace analysis {
+
+namespace {
+
+/** Strip the trailing newline fgets leaves on a line. */
+void chomp(std::string &s) {
+  while (!s.empty() && (s.back() == '\n' || s.back() == '\r')) {
+    s.pop_back();
+  }
+}
+
+} // namespace
+
+SymbolResolver::~SymbolResolver() {
+  for (auto &entry : libraries_) {
+    close_coprocess(entry.second->proc);
+  }
+}
+
+SymbolResolver::LibraryEntry &
+SymbolResolver::entry_for(const std::string &library_path) {
+  std::lock_guard<std::mutex> lock(libraries_mutex_);
+  auto &slot = libraries_[library_path];
+  if (!slot) {
+    slot = std::make_unique<LibraryEntry>();
+  }
+  return *slot;
+}
+
+SymbolInfo SymbolResolver::resolve(const std::string &library_path,
+                                   uintptr_t offset) {
+  LibraryEntry &entry = entry_for(library_path);
+  std::lock_guard<std::mutex> lock(entry.mutex);
+  auto it = entry.cache.find(offset);
+  if (it != entry.cache.end()) {
+    cache_hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second;
+  }
+  cache_misses_.fetch_add(1, std::memory_order_relaxed);
+
+  SymbolInfo info = resolve_in_entry(entry, library_path, offset);
+  entry.cache.emplace(offset, info);
+  return info;
+}
+
+bool SymbolResolver::spawn_coprocess(const std::string &library_path,
+                                     Coprocess &proc) {
+  int to_child[2];
+  int from_child[2];
+  if (pipe(to_child) != 0) {
+    return false;
+  }
+  if (pipe(from_child) != 0) {
+    close(to_child[0]);
+    close(to_child[1]);
+    return false;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, to_child[0], 0);
+  posix_spawn_file_actions_adddup2(&actions, from_child[1], 1);
+  // addr2line complains to stderr about missing debug info; keep that
+  // off the console as the old "2>/dev/null" redirect did.
+  posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addclose(&actions, to_child[1]);
+  posix_spawn_file_actions_addclose(&actions, from_child[0]);
+
+  const char *argv[] = {"addr2line", "-C", "-f", "-e", library_path.c_str(),
+                        nullptr};
+  pid_t pid = -1;
+  int rc = posix_spawnp(&pid, "addr2line", &actions, nullptr,
+                        const_cast<char *const *>(argv), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(to_child[0]);
+  close(from_child[1]);
+  if (rc != 0) {
+    close(to_child[1]);
+    close(from_child[0]);
+    return false;
+  }
+
+  proc.to_child = fdopen(to_child[1], "w");
+  proc.from_child = fdopen(from_child[0], "r");
+  proc.pid = static_cast<int>(pid);
+  if (proc.to_child == nullptr || proc.from_child == nullptr) {
+    close_coprocess(proc);
+    return false;
+  }
+  return true;
+}
+
+void SymbolResolver::close_coprocess(Coprocess &proc) {
+  if (proc.to_child != nullptr) {
+    fclose(proc.to_child);
+    proc.to_child = nullptr;
+  }
+  if (proc.from_child != nullptr) {
+    fclose(proc.from_child);
+    proc.from_child = nullptr;
+  }
+  if (proc.pid > 0) {
+    waitpid(proc.pid, nullptr, 0);
+    proc.pid = -1;
+  }
+}
+
+SymbolInfo SymbolResolver::resolve_in_entry(LibraryEntry &entry,
+                                            const std::string &library_path,
+                                            uintptr_t offset) {
+  SymbolInfo info;
+
+  if (entry.proc.pid < 0) {
+    bool fresh = !entry.spawn_attempted;
+    entry.spawn_attempted = true;
+    if (!fresh || !spawn_coprocess(library_path, entry.proc)) {
+      return info; // spawn failed before, or failed now
+    }
+  }
+
+  fprintf(entry.proc.to_child, "0x%lx\n", static_cast<unsigned long>(offset));
+  fflush(entry.proc.to_child);
+
+  char line[1024];
+  // First line: function name.
+  if (fgets(line, sizeof(line), entry.proc.from_child) == nullptr) {
+    // The child died; discard it. spawn_attempted is reset only for a
+    // child that answered before, so a library addr2line cannot read
+    // at all is never re-tried per address.
+    bool answered_before = !entry.cache.empty();
+    close_coprocess(entry.proc);
+    entry.spawn_attempted = !answered_before;
+    return info;
+  }
+  std::string func(line);
+  chomp(func);
+  if (func != "??") {
+    info.function_name = std::move(func);
+  }
+  // Second line: file:line.
+  if (fgets(line, sizeof(line), entry.proc.from_child) != nullptr) {
+    std::string loc(line);
+    chomp(loc);
+    size_t colon = loc.rfind(':');
+    if (colon != std::string::npos && loc.substr(0, colon) != "??") {
+      info.filename = loc.substr(0, colon);
+      // from_chars parses in place - no substr allocation, no locale,
+      // no exceptions (the extract_rank_from_filename pattern); a
+      // non-numeric tail like "?" just leaves the line at 0.
+      const char *begin = loc.data() + colon + 1;
+      const char *end = loc.data() + loc.size();
+      uint32_t line_number = 0;
+      auto res = std::from_chars(begin, end, line_number);
+      if (res.ec == std::errc{}) {
+        info.line_number = line_number;
+      }
+    }
+  }
+
+  if (__builtin_expect(debug_mode_, 0)) {
+    log_resolution(library_path, offset, info);
+  }
+  return info;
+}
+
+void SymbolResolver::log_resolution(const std::string &library_path,
+                                    uintptr_t offset,
+                                    const SymbolInfo &info) const {
+  fprintf(stderr, "[SymbolResolver] %s+0x%lx -> %s (%s:%u)\n",
+          library_path.c_str(), static_cast<unsigned long>(offset),
+          info.function_name.empty() ? "??" : info.function_name.c_str(),
+          info.filename.empty() ? "??" : info.filename.c_str(),
+          info.line_number);
+}
+
+} // namespace analysis
+} // namespace perflow
@@ -0,0 +1,110 @@
+#ifndef PERFLOW_ANALYSIS_SYMBOL_RESOLVER_H_
+#define PERFLOW_ANALYSIS_SYMBOL_RESOLVER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace perflow {
+namespace analysis {
+
+/** Symbol information for one (library, offset) pair. */
+struct SymbolInfo {
+  std::string function_name; /**<demangled function name, may be empty */
+  std::string filename;      /**<source file, may be empty */
+  uint32_t line_number = 0;  /**<source line, 0 if unknown */
+};
+
+/** Resolves (library path, offset) pairs to function/file/line via
+ * addr2line. Results are memoized in an in-process cache so repeated
+ * offsets (the common case across call stacks) are resolved once.
+ * One addr2line child is kept alive per library and fed addresses
+ * over a pipe, so a miss costs one round-trip on the pipe instead of
+ * a fork/exec plus a fresh DWARF parse per address.
+ *
+ * State is sharded per library: each library owns its offset-keyed
+ * cache, its coprocess and its lock, so lookups hash the path string
+ * once to find the shard and then work on integer keys, and
+ * resolutions against different libraries proceed in parallel. */
+class SymbolResolver {
+public:
+  SymbolResolver() = default;
+  ~SymbolResolver();
+
+  SymbolResolver(const SymbolResolver &) = delete;
+  SymbolResolver &operator=(const SymbolResolver &) = delete;
+
+  /** Resolve one offset within a library.
+   * @param library_path - path of the shared object or executable.
+   * @param offset - offset within the object.
+   * @return symbol info; fields are empty/0 when resolution fails.
+   */
+  SymbolInfo resolve(const std::string &library_path, uintptr_t offset);
+
+  /** Enable verbose logging of each resolution to stderr. */
+  void set_debug_mode(bool enable) { debug_mode_ = enable; }
+
+  uint64_t cache_hits() const {
+    return cache_hits_.load(std::memory_order_relaxed);
+  }
+  uint64_t cache_misses() const {
+    return cache_misses_.load(std::memory_order_relaxed);
+  }
+
+  /** Fraction of resolve() calls served from the cache. */
+  double hit_rate() const {
+    uint64_t total = cache_hits() + cache_misses();
+    return total == 0 ? 0.0 : static_cast<double>(cache_hits()) / total;
+  }
+
+private:
+  /** One persistent addr2line child. pid < 0 marks a library whose
+   * spawn failed permanently, so bad paths are not re-tried per
+   * address. */
+  struct Coprocess {
+    FILE *to_child = nullptr;   /**<we write addresses here */
+    FILE *from_child = nullptr; /**<we read two lines per address */
+    int pid = -1;
+  };
+
+  /** Per-library shard: offset cache, coprocess and lock. Held by
+   * unique_ptr so shards stay put when the shard map rehashes. */
+  struct LibraryEntry {
+    std::mutex mutex; /**<guards cache and coprocess I/O */
+    std::unordered_map<uintptr_t, SymbolInfo> cache;
+    Coprocess proc;
+    bool spawn_attempted = false;
+  };
+
+  /** Find or create the shard for a library (brief map lock only). */
+  LibraryEntry &entry_for(const std::string &library_path);
+
+  /** Resolve through the shard's coprocess; entry.mutex must be held. */
+  SymbolInfo resolve_in_entry(LibraryEntry &entry,
+                              const std::string &library_path,
+                              uintptr_t offset);
+
+  bool spawn_coprocess(const std::string &library_path, Coprocess &proc);
+  void close_coprocess(Coprocess &proc);
+
+  /** Out-of-line debug print, so the formatting code stays off the
+   * resolve path's I-cache when debug mode is off (the usual case). */
+  __attribute__((noinline)) void log_resolution(const std::string &library_path,
+                                                uintptr_t offset,
+                                                const SymbolInfo &info) const;
+
+  std::unordered_map<std::string, std::unique_ptr<LibraryEntry>> libraries_;
+  std::mutex libraries_mutex_;
+  std::atomic<uint64_t> cache_hits_{0};
+  std::atomic<uint64_t> cache_misses_{0};
+  bool debug_mode_ = false;
+};
+
+} // namespace analysis
+} // namespace perflow
+
+#endif
@@ -0,0 +1,294 @@
+#include "perflow/analysis/tree_serializer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace perflow {
+namespace analysis {
+
+namespace {
+
+/** Append-only file writer over one heap buffer and a raw fd. Records
+ * are memcpy'd into the buffer and handed to write(2) only when it
+ * fills, so a multi-field node record costs a handful of memcpys
+ * instead of one locked stdio call per field, and the whole file goes
+ * out in O(size / kBufferCapacity) syscalls. */
+class BufferedWriter {
+public:
+  static constexpr size_t kBufferCapacity = 4u << 20;
+
+  explicit BufferedWriter(const std::string &filepath) {
+    fd_ = ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ >= 0) {
+      // Advisory only - exported trees are written once, front to
+      // back, and rarely read back by this process, so tell the
+      // kernel not to shape readahead or cache policy around them.
+      ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    buf_.reserve(kBufferCapacity);
+  }
+
+  ~BufferedWriter() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  BufferedWriter(const BufferedWriter &) = delete;
+  BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+  bool is_open() const { return fd_ >= 0; }
+
+  void append(const void *data, size_t len) {
+    if (buf_.size() + len > kBufferCapacity) {
+      flush();
+      if (len > kBufferCapacity) {
+        // Oversized record: bypass the buffer rather than growing it.
+        write_all(data, len);
+        return;
+      }
+    }
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    buf_.insert(buf_.end(), bytes, bytes + len);
+  }
+
+  /** Drain the buffer and report whether every write succeeded. */
+  bool finish() {
+    flush();
+    if (ok_ && fd_ >= 0) {
+      // Multi-GB tree files would otherwise squat in the page cache
+      // at the expense of the sample data still being analyzed; start
+      // writeback and drop what is already clean.
+      ::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    return ok_;
+  }
+
+private:
+  void flush() {
+    if (!buf_.empty()) {
+      write_all(buf_.data(), buf_.size());
+      buf_.clear();
+    }
+  }
+
+  void write_all(const void *data, size_t len) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    while (ok_ && len > 0) {
+      ssize_t n = ::write(fd_, bytes, len);
+      if (n < 0) {
+        ok_ = false;
+        return;
+      }
+      bytes += n;
+      len -= static_cast<size_t>(n);
+    }
+  }
+
+  std::vector<uint8_t> buf_;
+  int fd_ = -1;
+  bool ok_ = true;
+};
+
+/** Fixed-size binary file header. */
+struct TreeFileHeader {
+  uint32_t magic = TreeSerializer::kTreeFileMagic;
+  uint32_t version = TreeSerializer::kTreeFormatVersion;
+  uint32_t process_count = 0;
+  uint32_t reserved = 0;
+  uint64_t node_count = 0; /**<includes the virtual root at index 0 */
+};
+
+/** Join directory, base name and suffix in one pass. */
+std::string make_filepath(const std::string &directory,
+                          const std::string &filename, const char *suffix) {
+  std::string path;
+  path.reserve(directory.size() + filename.size() + 16);
+  path = directory;
+  if (!path.empty() && path.back() != '/') {
+    path += '/';
+  }
+  path += filename;
+  path += suffix;
+  return path;
+}
+
+/** Length-prefixed string: uint16 length + bytes, no terminator. */
+void write_string(BufferedWriter &out, const std::string &s) {
+  uint16_t len = static_cast<uint16_t>(
+      s.size() < UINT16_MAX ? s.size() : UINT16_MAX);
+  out.append(&len, sizeof(len));
+  out.append(s.data(), len);
+}
+
+/** File-level string deduplication: every distinct name is written
+ * once in the table after the header, and node records carry uint32
+ * ids. On unresolved profiles - where every frame repeats the same
+ * "[unknown]" names - this collapses the dominant share of the file
+ * to 4 bytes per field. */
+class StringTable {
+public:
+  uint32_t intern(const std::string &s) {
+    auto it = ids_.find(s);
+    if (it != ids_.end()) {
+      return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(strings_.size());
+    ids_.emplace(s, id);
+    strings_.push_back(&s);
+    return id;
+  }
+
+  void write(BufferedWriter &out) const {
+    uint32_t count = static_cast<uint32_t>(strings_.size());
+    out.append(&count, sizeof(count));
+    for (const std::string *s : strings_) {
+      write_string(out, *s);
+    }
+  }
+
+private:
+  /** Keys reference the frames of the tree being serialized, which
+   * outlive the export. */
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<const std::string *> strings_;
+};
+
+/** One node record, in flat-snapshot order. The children of node i
+ * occupy the contiguous record range [first_child, first_child +
+ * child_count), so the on-disk layout needs no parent ids. */
+void write_node(BufferedWriter &out, const PerformanceTree::FlatNode &flat,
+                StringTable &strings) {
+  const TreeNode &node = *flat.node;
+  const sampling::ResolvedFrame &frame = node.frame();
+  uint32_t name_ids[3] = {strings.intern(frame.function_name),
+                          strings.intern(frame.library_name),
+                          strings.intern(frame.filename)};
+  out.append(name_ids, sizeof(name_ids));
+  uint64_t header[4] = {frame.raw_address, frame.offset, node.total_samples(),
+                        node.self_samples()};
+  uint32_t line = frame.line_number;
+  uint32_t child_count = flat.child_count;
+  // The per-process arrays grow lazily, so their length is per node.
+  const std::vector<uint64_t> &counts = node.sampling_counts();
+  const std::vector<double> &times = node.execution_times();
+  uint32_t n_procs = static_cast<uint32_t>(counts.size());
+  out.append(header, sizeof(header));
+  out.append(&line, sizeof(line));
+  out.append(&child_count, sizeof(child_count));
+  out.append(&n_procs, sizeof(n_procs));
+  // Contiguous vectors: the per-process counters land as two bulk
+  // copies instead of one call per element.
+  out.append(counts.data(), n_procs * sizeof(uint64_t));
+  out.append(times.data(), n_procs * sizeof(double));
+}
+
+/** Decimal formatting straight into the writer; to_chars does no
+ * format-string parsing, no locale and no locking. */
+void append_u64(BufferedWriter &out, uint64_t value) {
+  char digits[20];
+  auto res = std::to_chars(digits, digits + sizeof(digits), value);
+  out.append(digits, static_cast<size_t>(res.ptr - digits));
+}
+
+void append_str(BufferedWriter &out, const char *s) {
+  out.append(s, std::strlen(s));
+}
+
+} // namespace
+
+bool TreeSerializer::export_tree(const PerformanceTree &tree,
+                                 const std::string &directory,
+                                 const std::string &filename) const {
+  std::string filepath = make_filepath(directory, filename, ".ptree");
+  BufferedWriter out(filepath);
+  if (!out.is_open()) {
+    return false;
+  }
+
+  PerformanceTree::FlatTree flat = tree.flatten();
+  TreeFileHeader header;
+  header.process_count = static_cast<uint32_t>(tree.process_count());
+  header.node_count = flat.nodes.size();
+
+  // Intern every name up front so the table can precede the node
+  // records (readers build their id array before decoding nodes); the
+  // second pass then resolves to already-known ids.
+  StringTable strings;
+  for (const PerformanceTree::FlatNode &flat_node : flat.nodes) {
+    const sampling::ResolvedFrame &frame = flat_node.node->frame();
+    strings.intern(frame.function_name);
+    strings.intern(frame.library_name);
+    strings.intern(frame.filename);
+  }
+
+  out.append(&header, sizeof(header));
+  strings.write(out);
+  // Linear scan over the snapshot: records land in flat index order,
+  // so the child ranges recorded per node address records directly.
+  for (const PerformanceTree::FlatNode &flat_node : flat.nodes) {
+    write_node(out, flat_node, strings);
+  }
+  return out.finish();
+}
+
+bool TreeSerializer::export_tree_text(const PerformanceTree &tree,
+                                      const std::string &directory,
+                                      const std::string &filename) const {
+  std::string filepath = make_filepath(directory, filename, ".txt");
+  BufferedWriter out(filepath);
+  if (!out.is_open()) {
+    return false;
+  }
+
+  // The text report is preorder (children directly under their
+  // parent), produced by an explicit index stack over the level-order
+  // snapshot; the contiguous child ranges make the reversed push a
+  // plain countdown loop. Lines are assembled with to_chars into the
+  // same buffered writer as the binary path - no printf format
+  // parsing, no per-line stdio lock, one flush per buffer fill.
+  PerformanceTree::FlatTree flat = tree.flatten();
+  std::vector<uint32_t> stack;
+  stack.reserve(256);
+  if (!flat.nodes.empty()) {
+    stack.push_back(0);
+  }
+  // Indentation comes from one shared run of spaces grown to the
+  // deepest level seen, appended as a single slice per line.
+  std::string indent;
+  while (!stack.empty()) {
+    uint32_t index = stack.back();
+    stack.pop_back();
+    const PerformanceTree::FlatNode &flat_node = flat.nodes[index];
+    const TreeNode &node = *flat_node.node;
+    if (index != 0) { // the virtual root carries no samples
+      size_t width = static_cast<size_t>(flat_node.depth - 1) * 2;
+      if (indent.size() < width) {
+        indent.assign(width, ' ');
+      }
+      out.append(indent.data(), width);
+      out.append(node.frame().function_name.data(),
+                 node.frame().function_name.size());
+      append_str(out, " [");
+      append_u64(out, node.total_samples());
+      append_str(out, " samples, ");
+      append_u64(out, node.self_samples());
+      append_str(out, " self] (");
+      out.append(node.frame().library_name.data(),
+                 node.frame().library_name.size());
+      append_str(out, ")\n");
+    }
+    for (uint32_t c = flat_node.child_count; c-- > 0;) {
+      stack.push_back(flat_node.first_child + c);
+    }
+  }
+  return out.finish();
+}
+
+} // namespace analysis
+} // namespace perflow
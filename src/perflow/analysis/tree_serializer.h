@@ -0,0 +1,46 @@
+#ifndef PERFLOW_ANALYSIS_TREE_SERIALIZER_H_
+#define PERFLOW_ANALYSIS_TREE_SERIALIZER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "perflow/analysis/performance_tree.h"
+
+namespace perflow {
+namespace analysis {
+
+/** Writes a performance tree to disk, either as a compact binary
+ * `.ptree` file or as an indented text report.
+ *
+ * Both exports run over the tree's flattened snapshot (see
+ * PerformanceTree::flatten), so emission is an iterative linear scan
+ * of a contiguous node array - no recursion, no per-node shared_ptr
+ * traffic, and depth is bounded by an explicit work stack rather than
+ * the thread stack. */
+class TreeSerializer {
+public:
+  /** On-disk format version written into the file header. Version 2
+   * moved node name strings into a deduplicated table after the
+   * header; node records carry uint32 ids into it. */
+  static constexpr uint32_t kTreeFormatVersion = 2;
+  /** File magic: "PTRE" little-endian. */
+  static constexpr uint32_t kTreeFileMagic = 0x45525450u;
+
+  /** Write @p tree as a binary .ptree file.
+   * @param tree - the tree to serialize; counters must be synced.
+   * @param directory - destination directory (created by the caller).
+   * @param filename - base name; the ".ptree" suffix is appended.
+   * @return true on success. */
+  bool export_tree(const PerformanceTree &tree, const std::string &directory,
+                   const std::string &filename) const;
+
+  /** Write @p tree as an indented preorder text report (".txt"). */
+  bool export_tree_text(const PerformanceTree &tree,
+                        const std::string &directory,
+                        const std::string &filename) const;
+};
+
+} // namespace analysis
+} // namespace perflow
+
+#endif
@@ -0,0 +1,436 @@
+#include "perflow/analysis/tree_visualizer.h"
+
+#include <spawn.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+extern char **environ;
+
+namespace perflow {
+namespace analysis {
+
+namespace {
+
+/** Rough DOT bytes per node; sizes the output string up front. */
+constexpr size_t kAvgNodeBytes = 128;
+
+#ifdef _OPENMP
+/** Smallest graph worth parallel formatting; below this the fork/join
+ * overhead outweighs the string work. */
+constexpr size_t kParallelNodeThreshold = 4096;
+#endif
+
+/** Decimal formatting straight into the string; to_chars does no
+ * format-string parsing, no locale and no locking. */
+void append_u64(std::string &out, uint64_t value) {
+  char digits[20];
+  auto res = std::to_chars(digits, digits + sizeof(digits), value);
+  out.append(digits, static_cast<size_t>(res.ptr - digits));
+}
+
+/** Hue (degrees, 0..360) to RGB at full saturation and value, using
+ * the branchless absolute-value formulation instead of the classic
+ * six-sector switch: each channel is a clamped tent function of the
+ * hue, so there is no sector dispatch and no fmod. */
+void hsv_to_rgb(double h, int &r, int &g, int &b) {
+  double hh = h / 60.0;
+  double fr = std::clamp(std::fabs(hh - 3.0) - 1.0, 0.0, 1.0);
+  double fg = std::clamp(2.0 - std::fabs(hh - 2.0), 0.0, 1.0);
+  double fb = std::clamp(2.0 - std::fabs(hh - 4.0), 0.0, 1.0);
+  r = static_cast<int>(fr * 255.0);
+  g = static_cast<int>(fg * 255.0);
+  b = static_cast<int>(fb * 255.0);
+}
+
+/** RGB for one point of a scheme's gradient; only runs while the
+ * color tables are built. */
+void scheme_rgb(ColorScheme scheme, double ratio, int &r, int &g, int &b) {
+  r = g = b = 255;
+  switch (scheme) {
+  case ColorScheme::kHeatmap:
+    // White through yellow to red: blue falls off first, then green.
+    g = static_cast<int>(255.0 * (1.0 - ratio * 0.6));
+    b = static_cast<int>(255.0 * (1.0 - ratio));
+    break;
+  case ColorScheme::kGrayscale: {
+    int level = static_cast<int>(255.0 * (1.0 - ratio * 0.7));
+    r = g = b = level;
+    break;
+  }
+  case ColorScheme::kRainbow:
+    // Cold nodes blue (240 degrees), hot nodes red (0 degrees).
+    hsv_to_rgb(240.0 * (1.0 - ratio), r, g, b);
+    break;
+  }
+}
+
+/** "#rrggbb" into a 7-byte slot plus terminator: six digit lookups
+ * instead of snprintf's format parse and variadic dispatch. */
+void encode_rgb(char out[8], int r, int g, int b) {
+  static constexpr char kHexDigits[] = "0123456789abcdef";
+  out[0] = '#';
+  out[1] = kHexDigits[(r >> 4) & 15];
+  out[2] = kHexDigits[r & 15];
+  out[3] = kHexDigits[(g >> 4) & 15];
+  out[4] = kHexDigits[g & 15];
+  out[5] = kHexDigits[(b >> 4) & 15];
+  out[6] = kHexDigits[b & 15];
+  out[7] = '\0';
+}
+
+/** 256-entry "#rrggbb" gradient for one scheme. The sample ratio is
+ * quantized to 8 bits, so a node's fill color is a 7-byte slice of a
+ * cache-hot 2 KB table instead of per-node floating-point math and an
+ * snprintf; the gradients themselves are computed once per process. */
+struct ColorTable {
+  char entries[256][8];
+};
+
+struct ColorTables {
+  ColorTable schemes[3];
+};
+
+const ColorTable &table_for(ColorScheme scheme) {
+  static const ColorTables tables = [] {
+    ColorTables built{};
+    for (int s = 0; s < 3; s++) {
+      for (int i = 0; i < 256; i++) {
+        int r, g, b;
+        scheme_rgb(static_cast<ColorScheme>(s), i / 255.0, r, g, b);
+        encode_rgb(built.schemes[s].entries[i], r, g, b);
+      }
+    }
+    return built;
+  }();
+  return tables.schemes[static_cast<int>(scheme)];
+}
+
+/** Fill color for a node carrying @p samples out of @p max_samples. */
+void append_color(std::string &out, const ColorTable &table, uint64_t samples,
+                  uint64_t max_samples) {
+  uint32_t idx =
+      max_samples == 0
+          ? 0
+          : static_cast<uint32_t>((samples * 255ull) / max_samples);
+  out.append(table.entries[idx], 7);
+}
+
+/** Append @p name with DOT string escaping in one forward pass:
+ * runs free of quotes and backslashes (virtually every symbol name)
+ * go out as bulk appends, and no characters are ever shifted the way
+ * an escape-by-insertion pass would. */
+void append_escaped(std::string &out, const std::string &name) {
+  size_t start = 0;
+  for (size_t i = 0; i < name.size(); i++) {
+    char c = name[i];
+    if (c == '"' || c == '\\') {
+      out.append(name, start, i - start);
+      out += '\\';
+      out += c;
+      start = i + 1;
+    }
+  }
+  out.append(name, start, name.size() - start);
+}
+
+/** Node label: name plus sample count and share of total samples. */
+void append_label(std::string &out, const TreeNode &node,
+                  uint64_t total_samples) {
+  append_escaped(out, node.frame().function_name);
+  out += "\\n[";
+  append_u64(out, node.total_samples());
+  out += " samples, ";
+  // Fixed-point tenths of a percent, rounded: one integer divide
+  // instead of an FP divide plus snprintf's float formatting path.
+  uint64_t pct_x10 =
+      total_samples == 0
+          ? 0
+          : (node.total_samples() * 1000ull + total_samples / 2) /
+                total_samples;
+  append_u64(out, pct_x10 / 10);
+  out += '.';
+  out += static_cast<char>('0' + pct_x10 % 10);
+  out += "%]";
+}
+
+/** Join directory, base name and suffix in one pass. */
+std::string make_filepath(const std::string &directory,
+                          const std::string &filename, const char *suffix) {
+  std::string path;
+  path.reserve(directory.size() + filename.size() + 16);
+  path = directory;
+  if (!path.empty() && path.back() != '/') {
+    path += '/';
+  }
+  path += filename;
+  path += suffix;
+  return path;
+}
+
+} // namespace
+
+std::string
+TreeVisualizer::generate_dot_string(const PerformanceTree &tree) const {
+  PerformanceTree::FlatTree flat = tree.flatten();
+
+  // Color intensity is relative to the hottest non-root node; the
+  // label percentage is relative to the total sample count (the sum
+  // over the root's children, as in the hotspot report).
+  uint64_t max_samples = 0;
+  for (size_t i = 1; i < flat.nodes.size(); i++) {
+    max_samples = std::max(max_samples, flat.nodes[i].node->total_samples());
+  }
+  uint64_t total_samples = 0;
+  for (const auto &child : flat.nodes[0].node->children()) {
+    total_samples += child->total_samples();
+  }
+
+  // The scheme is invariant across the scan; resolve its gradient
+  // table once here instead of dispatching per node.
+  const ColorTable &colors = table_for(color_scheme_);
+
+  // Pruning: keep[] marks nodes above the sample threshold whose
+  // ancestors are all kept (one forward pass - level order guarantees
+  // parents precede children), and subtree_sizes[] (one reverse pass,
+  // children have higher indices) sizes the collapsed annotations.
+  uint64_t prune_threshold = 0;
+  std::vector<uint8_t> keep;
+  std::vector<uint64_t> subtree_sizes;
+  if (min_sample_ratio_ > 0.0 && max_samples > 0) {
+    prune_threshold = static_cast<uint64_t>(
+        min_sample_ratio_ * static_cast<double>(max_samples));
+    keep.assign(flat.nodes.size(), 0);
+    keep[0] = 1;
+    for (size_t i = 0; i < flat.nodes.size(); i++) {
+      if (!keep[i]) {
+        continue;
+      }
+      const PerformanceTree::FlatNode &fn = flat.nodes[i];
+      for (uint32_t c = 0; c < fn.child_count; c++) {
+        size_t child = fn.first_child + c;
+        keep[child] =
+            flat.nodes[child].node->total_samples() >= prune_threshold;
+      }
+    }
+    subtree_sizes.assign(flat.nodes.size(), 1);
+    for (size_t i = flat.nodes.size(); i-- > 0;) {
+      const PerformanceTree::FlatNode &fn = flat.nodes[i];
+      for (uint32_t c = 0; c < fn.child_count; c++) {
+        subtree_sizes[i] += subtree_sizes[fn.first_child + c];
+      }
+    }
+  }
+
+  // Compaction: subtree_zero[] marks nodes with no samples anywhere
+  // below them (one reverse pass, like the pruning sizes above).
+  std::vector<uint8_t> subtree_zero;
+  if (compact_zero_samples_) {
+    subtree_zero.assign(flat.nodes.size(), 0);
+    for (size_t i = flat.nodes.size(); i-- > 0;) {
+      const PerformanceTree::FlatNode &fn = flat.nodes[i];
+      bool zero = fn.node->total_samples() == 0;
+      for (uint32_t c = 0; zero && c < fn.child_count; c++) {
+        zero = subtree_zero[fn.first_child + c] != 0;
+      }
+      subtree_zero[i] = zero;
+    }
+  }
+
+  std::string out;
+  out.reserve(flat.nodes.size() * kAvgNodeBytes);
+  out += "digraph PerformanceTree {\n";
+  out += "  node [style=filled, shape=box];\n";
+
+  // One node plus its outgoing edges; ids are flat indices, so any
+  // emission order yields the same graph and the body can be produced
+  // by independent workers.
+  // "0 means unbounded" is resolved once: with the sentinel no depth
+  // can exceed the limit, so the per-node checks below are a single
+  // compare without re-testing whether a bound is set at all.
+  const size_t depth_limit = max_depth_ > 0 ? max_depth_ : SIZE_MAX;
+
+  auto emit_node = [&](std::string &dst, size_t i) {
+    const PerformanceTree::FlatNode &flat_node = flat.nodes[i];
+    if (flat_node.depth > depth_limit) {
+      return;
+    }
+    if (!keep.empty() && !keep[i]) {
+      return;
+    }
+    // Nodes whose whole subtree carries no samples are pure structure
+    // (e.g. [unknown] frames threaded through by unsampled paths); a
+    // bare point skips the label, escape and color work and takes no
+    // layout area. The subtree test - not the node's own total - is
+    // what keeps names on exclusive-count interiors above live
+    // leaves. All descendants are zero too, so their edges stay and
+    // they emit their own points.
+    if (!subtree_zero.empty() && i != 0 && subtree_zero[i]) {
+      dst += "  node";
+      append_u64(dst, i);
+      dst += " [shape=point];\n";
+      if (flat_node.depth == depth_limit || flat_node.child_count == 0) {
+        return;
+      }
+      dst += "  node";
+      append_u64(dst, i);
+      dst += " -> {";
+      for (uint32_t c = 0; c < flat_node.child_count; c++) {
+        dst += " node";
+        append_u64(dst, flat_node.first_child + c);
+      }
+      dst += " };\n";
+      return;
+    }
+    dst += "  node";
+    append_u64(dst, i);
+    dst += " [label=\"";
+    if (i == 0) {
+      dst += "[root]";
+    } else {
+      append_label(dst, *flat_node.node, total_samples);
+    }
+    dst += "\", fillcolor=\"";
+    append_color(dst, colors, i == 0 ? 0 : flat_node.node->total_samples(),
+                 max_samples);
+    dst += "\"];\n";
+    if (flat_node.depth == depth_limit) {
+      return; // children are beyond the bound
+    }
+    uint64_t pruned_nodes = 0;
+    uint64_t pruned_samples = 0;
+    size_t first_pruned = 0;
+    bool any_edge = false;
+    for (uint32_t c = 0; c < flat_node.child_count; c++) {
+      size_t child = flat_node.first_child + c;
+      if (!keep.empty() && !keep[child]) {
+        // Collapsed below the threshold; accounted for in one
+        // synthetic node after the loop.
+        if (pruned_nodes == 0) {
+          first_pruned = child;
+        }
+        pruned_nodes += subtree_sizes[child];
+        pruned_samples += flat.nodes[child].node->total_samples();
+        continue;
+      }
+      // All of a parent's edges go out as one "src -> { c1 c2 ... }"
+      // statement: fewer bytes, and one edge statement instead of K
+      // for Graphviz's parser to chew through downstream.
+      if (!any_edge) {
+        dst += "  node";
+        append_u64(dst, i);
+        dst += " -> {";
+        any_edge = true;
+      }
+      dst += " node";
+      append_u64(dst, child);
+    }
+    if (any_edge) {
+      dst += " };\n";
+    }
+    if (pruned_nodes != 0) {
+      // The first pruned child's id is free (that node is not
+      // emitted), so the synthetic node reuses it - ids stay unique
+      // without any cross-chunk coordination.
+      dst += "  node";
+      append_u64(dst, first_pruned);
+      dst += " [label=\"[";
+      append_u64(dst, pruned_nodes);
+      dst += " nodes, ";
+      append_u64(dst, pruned_samples);
+      dst += " samples pruned]\", fillcolor=\"#eeeeee\"];\n  node";
+      append_u64(dst, i);
+      dst += " -> node";
+      append_u64(dst, first_pruned);
+      dst += ";\n";
+    }
+  };
+
+#ifdef _OPENMP
+  // Large graphs format in parallel: contiguous index chunks go into
+  // per-chunk strings (no shared state beyond the read-only snapshot)
+  // and concatenate in chunk order, so the output is byte-identical
+  // to the serial scan.
+  if (flat.nodes.size() >= kParallelNodeThreshold) {
+    size_t chunk_count = std::min<size_t>(
+        {flat.nodes.size() / kParallelNodeThreshold + 1,
+         std::thread::hardware_concurrency(), 16});
+    if (chunk_count == 0) {
+      chunk_count = 1; // hardware_concurrency() may report 0
+    }
+    size_t per_chunk = (flat.nodes.size() + chunk_count - 1) / chunk_count;
+    std::vector<std::string> parts(chunk_count);
+#pragma omp parallel for schedule(static)
+    for (size_t c = 0; c < chunk_count; c++) {
+      size_t begin = c * per_chunk;
+      size_t end = std::min(begin + per_chunk, flat.nodes.size());
+      parts[c].reserve((end - begin) * kAvgNodeBytes);
+      for (size_t i = begin; i < end; i++) {
+        emit_node(parts[c], i);
+      }
+    }
+    for (const std::string &part : parts) {
+      out += part;
+    }
+    out += "}\n";
+    return out;
+  }
+#endif
+
+  // One linear scan: node ids are flat indices, and a node's children
+  // occupy a contiguous id range, so nodes and their outgoing edges
+  // are emitted together without any descent bookkeeping.
+  for (size_t i = 0; i < flat.nodes.size(); i++) {
+    emit_node(out, i);
+  }
+  out += "}\n";
+  return out;
+}
+
+bool TreeVisualizer::generate_dot(const PerformanceTree &tree,
+                                  const std::string &directory,
+                                  const std::string &filename) const {
+  std::string dot = generate_dot_string(tree);
+  std::string filepath = make_filepath(directory, filename, ".dot");
+  std::FILE *file = std::fopen(filepath.c_str(), "w");
+  if (file == nullptr) {
+    return false;
+  }
+  // The whole graph was assembled in memory; one bulk write.
+  bool ok = std::fwrite(dot.data(), 1, dot.size(), file) == dot.size();
+  return std::fclose(file) == 0 && ok;
+}
+
+bool TreeVisualizer::generate_pdf(const PerformanceTree &tree,
+                                  const std::string &directory,
+                                  const std::string &filename) const {
+  if (!generate_dot(tree, directory, filename)) {
+    return false;
+  }
+  std::string dot_path = make_filepath(directory, filename, ".dot");
+  std::string pdf_path = make_filepath(directory, filename, ".pdf");
+  // Spawn dot directly (the symbol resolver's coprocess pattern): no
+  // shell between us and Graphviz, so no quoting of the paths and one
+  // fewer process per render.
+  const char *argv[] = {"dot",          "-Tpdf", dot_path.c_str(),
+                        "-o",           pdf_path.c_str(), nullptr};
+  pid_t pid = -1;
+  if (posix_spawnp(&pid, "dot", nullptr, nullptr,
+                   const_cast<char *const *>(argv), environ) != 0) {
+    return false;
+  }
+  int status = 0;
+  if (waitpid(pid, &status, 0) < 0) {
+    return false;
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace analysis
+} // namespace perflow
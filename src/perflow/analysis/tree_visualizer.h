@@ -0,0 +1,84 @@
+#ifndef PERFLOW_ANALYSIS_TREE_VISUALIZER_H_
+#define PERFLOW_ANALYSIS_TREE_VISUALIZER_H_
+
+#include <cstddef>
+#include <string>
+
+#include "perflow/analysis/performance_tree.h"
+
+namespace perflow {
+namespace analysis {
+
+/** How node fill colors encode a node's share of the hottest node's
+ * samples. */
+enum class ColorScheme {
+  kHeatmap,   /**<white through yellow to red */
+  kGrayscale, /**<white (cold) to dark gray (hot) */
+  kRainbow,   /**<blue (cold) through green to red (hot) */
+};
+
+/** Renders a performance tree as a Graphviz DOT graph (and, with dot
+ * installed, a PDF).
+ *
+ * Emission runs over the tree's flattened snapshot (see
+ * PerformanceTree::flatten): node ids are the flat indices, so the
+ * whole graph is produced by one linear scan of a contiguous array
+ * into a single pre-sized output string - no recursion, no per-node
+ * shared_ptr traffic, and one write to disk at the end. */
+class TreeVisualizer {
+public:
+  void set_color_scheme(ColorScheme scheme) { color_scheme_ = scheme; }
+  ColorScheme color_scheme() const { return color_scheme_; }
+
+  /** Limit the rendered depth; 0 (the default) renders everything. */
+  void set_max_depth(size_t max_depth) { max_depth_ = max_depth; }
+  size_t max_depth() const { return max_depth_; }
+
+  /** Prune subtrees whose share of the hottest node's samples falls
+   * below @p min_ratio; a parent's pruned children collapse into one
+   * synthetic "[N nodes, S samples pruned]" node. 0 (the default)
+   * renders everything. Invisible nodes dominate both emission and
+   * the dot layout time on large profiles, so even a small ratio
+   * shrinks renders by orders of magnitude. */
+  void set_min_sample_ratio(double min_ratio) {
+    min_sample_ratio_ = min_ratio;
+  }
+  double min_sample_ratio() const { return min_sample_ratio_; }
+
+  /** Render nodes that carry no samples anywhere in their subtree as
+   * bare points instead of labeled boxes (on by default). Such nodes
+   * are pure structure - [unknown] frames threaded through by deeper
+   * paths - and skipping their labels saves both formatting work and
+   * dot layout area. */
+  void set_compact_zero_samples(bool enable) {
+    compact_zero_samples_ = enable;
+  }
+  bool compact_zero_samples() const { return compact_zero_samples_; }
+
+  /** Render @p tree as DOT text. */
+  std::string generate_dot_string(const PerformanceTree &tree) const;
+
+  /** Write @p tree as a .dot file.
+   * @param tree - the tree to render; counters must be synced.
+   * @param directory - destination directory (created by the caller).
+   * @param filename - base name; the ".dot" suffix is appended.
+   * @return true on success. */
+  bool generate_dot(const PerformanceTree &tree, const std::string &directory,
+                    const std::string &filename) const;
+
+  /** Write the .dot file and run Graphviz dot over it to produce
+   * "<filename>.pdf". Requires dot on PATH. */
+  bool generate_pdf(const PerformanceTree &tree, const std::string &directory,
+                    const std::string &filename) const;
+
+private:
+  ColorScheme color_scheme_ = ColorScheme::kHeatmap;
+  size_t max_depth_ = 0;
+  double min_sample_ratio_ = 0.0;
+  bool compact_zero_samples_ = true;
+};
+
+} // namespace analysis
+} // namespace perflow
+
+#endif
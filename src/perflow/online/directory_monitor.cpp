@@ -0,0 +1,179 @@
+#include "perflow/online/directory_monitor.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace perflow {
+namespace online {
+
+namespace {
+
+// SWAR suffix dispatch: the last (up to) 8 path bytes are packed into one
+// uint64_t, end-aligned to the high byte, so each candidate extension is a
+// single mask + compare against a compile-time constant.
+constexpr uint64_t suffix_mask(size_t len) {
+  return ~uint64_t(0) << (8 * (8 - len));
+}
+
+constexpr uint64_t suffix_key(const char *s, size_t len) {
+  uint64_t key = 0;
+  for (size_t i = 0; i < len; i++) {
+    key |= static_cast<uint64_t>(static_cast<unsigned char>(s[i]))
+           << (8 * (8 - len + i));
+  }
+  return key;
+}
+
+constexpr uint64_t kPflwKey = suffix_key(".pflw", 5);
+constexpr uint64_t kLibmapKey = suffix_key(".libmap", 7);
+constexpr uint64_t kPtreeKey = suffix_key(".ptree", 6);
+constexpr uint64_t kTxtKey = suffix_key(".txt", 4);
+
+} // namespace
+
+FileType DirectoryMonitor::get_file_type(const std::string &path) {
+  size_t len = path.size();
+  if (len < 4) {
+    return FileType::kUnknown;
+  }
+  size_t n = len < 8 ? len : 8;
+  uint64_t tail = 0;
+  // Little-endian load, end-aligned: the path's last byte lands in the
+  // most significant byte of tail.
+  memcpy(reinterpret_cast<char *>(&tail) + (8 - n), path.data() + len - n, n);
+
+  if ((tail & suffix_mask(5)) == kPflwKey) {
+    return FileType::kSampleData;
+  }
+  if (len >= 7 && (tail & suffix_mask(7)) == kLibmapKey) {
+    return FileType::kLibraryMap;
+  }
+  if (len >= 6 && (tail & suffix_mask(6)) == kPtreeKey) {
+    return FileType::kPerformanceTree;
+  }
+  if ((tail & suffix_mask(4)) == kTxtKey) {
+    return FileType::kText;
+  }
+  return FileType::kUnknown;
+}
+
+void DirectoryMonitor::set_callback(FileCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  callback_ = std::move(callback);
+}
+
+void DirectoryMonitor::scan() { run_scan(); }
+
+void DirectoryMonitor::start() {
+  if (running_.exchange(true)) {
+    return;
+  }
+  monitor_thread_ = std::thread(&DirectoryMonitor::monitor_loop, this);
+}
+
+void DirectoryMonitor::stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+  if (monitor_thread_.joinable()) {
+    monitor_thread_.join();
+  }
+}
+
+void DirectoryMonitor::monitor_loop() {
+  while (running_.load(std::memory_order_relaxed)) {
+    run_scan();
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(poll_interval_ms_));
+  }
+}
+
+void DirectoryMonitor::run_scan() {
+  // Phase 1: all I/O (readdir/stat) without holding mutex_, so scan()
+  // and set_callback() are never blocked behind syscalls.
+  std::vector<ScanEntry> entries;
+  scan_directory(entries);
+
+  // Phase 2: briefly lock to merge into file_info_ and snapshot the
+  // callback.
+  std::vector<ChangeEvent> changes;
+  FileCallback cb;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const ScanEntry &e : entries) {
+      // Hash each path exactly once per scan.
+      size_t hash = std::hash<std::string>()(e.path);
+      FileInfo *info = file_info_.find(e.path, hash);
+      bool is_new = (info == nullptr);
+      if (!is_new && info->last_modified_ns == e.mtime_ns &&
+          info->size == e.size) {
+        continue;
+      }
+      if (is_new) {
+        info = &file_info_.insert(e.path, hash);
+        info->type = get_file_type(e.path);
+      }
+      info->last_modified_ns = e.mtime_ns;
+      info->size = e.size;
+      changes.push_back(ChangeEvent{e.path, info->type, is_new});
+    }
+    cb = callback_;
+  }
+
+  // Phase 3: fire the callback outside the lock, so a slow consumer
+  // cannot freeze the monitor.
+  if (cb) {
+    for (const ChangeEvent &c : changes) {
+      cb(c.path, c.type, c.is_new);
+    }
+  }
+}
+
+void DirectoryMonitor::scan_directory(std::vector<ScanEntry> &entries) {
+  // Hand-rolled BFS over subdirectories using opendir/readdir; no shell,
+  // no fork.
+  std::vector<std::string> pending;
+  pending.push_back(directory_);
+  while (!pending.empty()) {
+    std::string dir = std::move(pending.back());
+    pending.pop_back();
+
+    DIR *d = opendir(dir.c_str());
+    if (d == nullptr) {
+      continue;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(d)) != nullptr) {
+      const char *name = entry->d_name;
+      if (name[0] == '.' &&
+          (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        continue;
+      }
+      std::string path = dir;
+      path += '/';
+      path += name;
+
+      struct stat st;
+      if (stat(path.c_str(), &st) != 0) {
+        continue;
+      }
+      if (S_ISDIR(st.st_mode)) {
+        pending.push_back(std::move(path));
+      } else if (S_ISREG(st.st_mode)) {
+        int64_t mtime_ns =
+            static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+            st.st_mtim.tv_nsec;
+        entries.push_back(ScanEntry{std::move(path), mtime_ns,
+                                    static_cast<uint64_t>(st.st_size)});
+      }
+    }
+    closedir(d);
+  }
+}
+
+} // namespace online
+} // namespace perflow
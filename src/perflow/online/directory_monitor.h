@@ -0,0 +1,168 @@
+#ifndef PERFLOW_ONLINE_DIRECTORY_MONITOR_H_
+#define PERFLOW_ONLINE_DIRECTORY_MONITOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace perflow {
+namespace online {
+
+/** File categories the online pipeline reacts to. */
+enum class FileType {
+  kUnknown,
+  kSampleData,      /**<.pflw raw sample files */
+  kLibraryMap,      /**<.libmap snapshot files */
+  kPerformanceTree, /**<.ptree serialized trees */
+  kText,            /**<.txt reports */
+};
+
+/** Per-file state tracked between scans. last_modified_ns carries the
+ * full st_mtim nanosecond timestamp: second-granularity mtime misses
+ * rewrites that land within the same second as the previous scan. */
+struct FileInfo {
+  std::string path;
+  FileType type = FileType::kUnknown;
+  int64_t last_modified_ns = 0;
+  uint64_t size = 0;
+};
+
+using FileCallback =
+    std::function<void(const std::string &path, FileType type, bool is_new)>;
+
+/** Open-addressed (linear probing) map from path to FileInfo with the
+ * hash computed once by the caller and stored in the slot. Entries are
+ * never erased, which keeps probing tombstone-free; lookups touch one
+ * contiguous slot array instead of chasing per-node heap allocations. */
+class FlatFileMap {
+public:
+  FlatFileMap() : slots_(kInitialCapacity) {}
+
+  /** Find the entry for path, nullptr if absent. */
+  FileInfo *find(const std::string &path, size_t hash) {
+    size_t mask = slots_.size() - 1;
+    for (size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+      Slot &slot = slots_[idx];
+      if (!slot.used) {
+        return nullptr;
+      }
+      if (slot.hash == hash && slot.info.path == path) {
+        return &slot.info;
+      }
+    }
+  }
+
+  /** Insert a new entry (path must not be present yet). */
+  FileInfo &insert(const std::string &path, size_t hash) {
+    if ((size_ + 1) * 10 >= slots_.size() * 7) {
+      grow();
+    }
+    size_t mask = slots_.size() - 1;
+    size_t idx = hash & mask;
+    while (slots_[idx].used) {
+      idx = (idx + 1) & mask;
+    }
+    Slot &slot = slots_[idx];
+    slot.used = true;
+    slot.hash = hash;
+    slot.info.path = path;
+    size_++;
+    return slot.info;
+  }
+
+  size_t size() const { return size_; }
+
+private:
+  struct Slot {
+    bool used = false;
+    size_t hash = 0;
+    FileInfo info;
+  };
+
+  static constexpr size_t kInitialCapacity = 64;
+
+  void grow() {
+    std::vector<Slot> old;
+    old.swap(slots_);
+    slots_.resize(old.size() * 2);
+    size_t mask = slots_.size() - 1;
+    for (Slot &s : old) {
+      if (!s.used) {
+        continue;
+      }
+      size_t idx = s.hash & mask;
+      while (slots_[idx].used) {
+        idx = (idx + 1) & mask;
+      }
+      slots_[idx] = std::move(s);
+    }
+  }
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+};
+
+/** Polls a directory tree for new or modified profile files and invokes
+ * a callback for each change. */
+class DirectoryMonitor {
+public:
+  explicit DirectoryMonitor(std::string directory,
+                            unsigned poll_interval_ms = 1000)
+      : directory_(std::move(directory)),
+        poll_interval_ms_(poll_interval_ms) {}
+  ~DirectoryMonitor() { stop(); }
+
+  DirectoryMonitor(const DirectoryMonitor &) = delete;
+  DirectoryMonitor &operator=(const DirectoryMonitor &) = delete;
+
+  void set_callback(FileCallback callback);
+
+  /** Run one scan immediately. */
+  void scan();
+
+  /** Start the background polling thread. */
+  void start();
+  /** Stop the background polling thread and join it. */
+  void stop();
+
+  /** Classify a path by its extension. */
+  static FileType get_file_type(const std::string &path);
+
+private:
+  struct ScanEntry {
+    std::string path;
+    int64_t mtime_ns;
+    uint64_t size;
+  };
+  struct ChangeEvent {
+    std::string path;
+    FileType type;
+    bool is_new;
+  };
+
+  void monitor_loop();
+  /** One scan: lock-free I/O phase, short merge under mutex_, callback
+   * invocation outside the lock. */
+  void run_scan();
+  /** Walk the directory tree collecting (path, mtime, size). Pure I/O;
+   * takes no lock. */
+  void scan_directory(std::vector<ScanEntry> &entries);
+
+  std::string directory_;
+  unsigned poll_interval_ms_;
+  FlatFileMap file_info_;
+  FileCallback callback_;
+  std::mutex mutex_;
+  std::thread monitor_thread_;
+  std::atomic<bool> running_{false};
+};
+
+} // namespace online
+} // namespace perflow
+
+#endif
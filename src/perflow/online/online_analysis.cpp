@@ -0,0 +1,146 @@
+#include "perflow/online/online_analysis.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace perflow {
+namespace online {
+
+OnlineAnalysis::OnlineAnalysis(std::string directory,
+                               unsigned poll_interval_ms)
+    : directory_(std::move(directory)),
+      monitor_(directory_, poll_interval_ms), reader_(1),
+      // Online frames are converted but not symbolized, so the
+      // context-free child key (function + library name) would
+      // collapse every address in a library into one node; keying on
+      // the offset keeps the call structure.
+      tree_(analysis::ConcurrencyMode::kSerial,
+            analysis::TreeBuildMode::kContextAware) {
+  processed_files_.reserve(1024);
+  reader_.set_offset_converter(&converter_);
+  monitor_.set_callback(
+      [this](const std::string &path, FileType type, bool is_new) {
+        handle_file(path, type, is_new);
+      });
+}
+
+void OnlineAnalysis::start() { monitor_.start(); }
+
+void OnlineAnalysis::stop() { monitor_.stop(); }
+
+uint32_t OnlineAnalysis::extract_rank_from_filename(const std::string &path) {
+  return analysis::ParallelFileReader::extract_rank_from_filename(path);
+}
+
+void OnlineAnalysis::handle_file(const std::string &path, FileType type,
+                                 bool is_new) {
+  if (type == FileType::kSampleData) {
+    // Fast path for re-deliveries of files already imported: a shared
+    // lock suffices for the membership probe.
+    std::shared_lock<std::shared_mutex> read_lock(mutex_);
+    if (processed_files_.find(path) != processed_files_.end()) {
+      return;
+    }
+  }
+  std::lock_guard<std::shared_mutex> lock(mutex_);
+  switch (type) {
+  case FileType::kLibraryMap: {
+    uint32_t rank = extract_rank_from_filename(path);
+    if (rank == analysis::kInvalidRank) {
+      return;
+    }
+    if (!load_library_map(path, rank)) {
+      pending_libmaps_[rank] = path;
+      break;
+    }
+    drain_pending_samples(rank);
+    break;
+  }
+  case FileType::kSampleData: {
+    // Re-check under the exclusive lock before importing.
+    if (processed_files_.find(path) != processed_files_.end()) {
+      return; // modification of an already-imported file; counted once
+    }
+    uint32_t rank = extract_rank_from_filename(path);
+    if (rank != analysis::kInvalidRank) {
+      auto pending = pending_libmaps_.find(rank);
+      if (pending != pending_libmaps_.end() &&
+          load_library_map(pending->second, rank)) {
+        pending_libmaps_.erase(pending);
+        drain_pending_samples(rank);
+      }
+      if (!converter_.has_snapshot(rank)) {
+        // The scan delivers files in readdir/BFS order, so a sample
+        // file can precede its rank's libmap; importing it now would
+        // resolve every frame as [unknown] and permanently mark the
+        // file done. Park it until the snapshot arrives.
+        std::vector<std::string> &parked = pending_samples_[rank];
+        if (std::find(parked.begin(), parked.end(), path) == parked.end()) {
+          parked.push_back(path);
+        }
+        return;
+      }
+    }
+    import_sample_file(path);
+    break;
+  }
+  default:
+    break;
+  }
+  (void)is_new;
+}
+
+void OnlineAnalysis::import_sample_file(const std::string &path) {
+  std::vector<std::string> files{path};
+  std::vector<analysis::FileReadResult> results =
+      reader_.read_files_parallel(files, tree_);
+  // A file the poller catches mid-write fails the import (truncated
+  // record) and contributes nothing; only a successful import marks
+  // it processed, so the change event after the writer finishes
+  // retries it instead of being swallowed.
+  if (!results.empty() && results.front().success) {
+    processed_files_.emplace(path);
+  }
+}
+
+void OnlineAnalysis::drain_pending_samples(uint32_t rank) {
+  auto parked = pending_samples_.find(rank);
+  if (parked == pending_samples_.end()) {
+    return;
+  }
+  std::vector<std::string> files = std::move(parked->second);
+  pending_samples_.erase(parked);
+  for (const std::string &file : files) {
+    import_sample_file(file);
+  }
+}
+
+size_t OnlineAnalysis::processed_file_count() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return processed_files_.size();
+}
+
+bool OnlineAnalysis::load_library_map(const std::string &path, uint32_t rank) {
+  FILE *file = std::fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return false;
+  }
+  sampling::LibraryMap map;
+  unsigned long long start = 0;
+  unsigned long long end = 0;
+  char name[512];
+  while (std::fscanf(file, "%llx %llx %511s", &start, &end, name) == 3) {
+    map.add_library(start, end, name);
+  }
+  std::fclose(file);
+  if (map.size() == 0) {
+    return false;
+  }
+  converter_.add_map_snapshot(rank, std::move(map));
+  return true;
+}
+
+} // namespace online
+} // namespace perflow
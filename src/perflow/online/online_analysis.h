@@ -0,0 +1,77 @@
+#ifndef PERFLOW_ONLINE_ONLINE_ANALYSIS_H_
+#define PERFLOW_ONLINE_ONLINE_ANALYSIS_H_
+
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "perflow/analysis/offset_converter.h"
+#include "perflow/analysis/parallel_file_reader.h"
+#include "perflow/analysis/performance_tree.h"
+#include "perflow/online/directory_monitor.h"
+
+namespace perflow {
+namespace online {
+
+/** Online post-processing pipeline: watches a measurement directory and
+ * folds sample files into a performance tree as they appear. Library
+ * map snapshots (.libmap, one per rank, text lines "start end name" in
+ * hex) are loaded into the converter before the rank's samples. */
+class OnlineAnalysis {
+public:
+  explicit OnlineAnalysis(std::string directory,
+                          unsigned poll_interval_ms = 1000);
+
+  OnlineAnalysis(const OnlineAnalysis &) = delete;
+  OnlineAnalysis &operator=(const OnlineAnalysis &) = delete;
+
+  /** Start / stop the background directory monitor. */
+  void start();
+  void stop();
+
+  /** Process one discovered file; registered as the monitor callback. */
+  void handle_file(const std::string &path, FileType type, bool is_new);
+
+  analysis::PerformanceTree &tree() { return tree_; }
+  size_t processed_file_count() const;
+
+  /** Parse the rank id out of a "..._rank_<N>.<ext>" filename;
+   * analysis::kInvalidRank if absent. */
+  static uint32_t extract_rank_from_filename(const std::string &path);
+
+private:
+  /** Load one .libmap snapshot and register it for @p rank. */
+  bool load_library_map(const std::string &path, uint32_t rank);
+
+  /** Import one sample file; marks it processed only on success. */
+  void import_sample_file(const std::string &path);
+
+  /** Import every sample file parked for @p rank (called once the
+   * rank's libmap snapshot is registered). */
+  void drain_pending_samples(uint32_t rank);
+
+  std::string directory_;
+  DirectoryMonitor monitor_;
+  analysis::OffsetConverter converter_;
+  analysis::ParallelFileReader reader_;
+  analysis::PerformanceTree tree_;
+
+  std::unordered_set<std::string> processed_files_;
+  /** libmap paths that failed to load, retried when the rank's samples
+   * arrive. */
+  std::unordered_map<uint32_t, std::string> pending_libmaps_;
+  /** Sample files whose rank has no libmap snapshot yet; scan order is
+   * readdir/BFS, so samples routinely precede their rank's libmap.
+   * Imported when the snapshot arrives. */
+  std::unordered_map<uint32_t, std::vector<std::string>> pending_samples_;
+  /** Read-mostly: repeated deliveries of already-processed files only
+   * take the shared side. */
+  mutable std::shared_mutex mutex_;
+};
+
+} // namespace online
+} // namespace perflow
+
+#endif
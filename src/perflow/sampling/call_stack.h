@@ -0,0 +1,86 @@
+#ifndef PERFLOW_SAMPLING_CALL_STACK_H_
+#define PERFLOW_SAMPLING_CALL_STACK_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace perflow {
+namespace sampling {
+
+/** Default upper bound on sampled call-stack depth. */
+constexpr size_t kDefaultMaxStackDepth = 64;
+
+/** A raw (unresolved) call stack as produced by the sampler: a fixed-size
+ * array of return addresses, leaf first. */
+template <size_t MaxDepth = kDefaultMaxStackDepth> struct RawCallStack {
+  std::array<uint64_t, MaxDepth> addresses = {0};
+  size_t num_frames = 0;
+
+  size_t depth() const { return num_frames; }
+
+  void push(uint64_t addr) {
+    if (num_frames < MaxDepth) {
+      addresses[num_frames++] = addr;
+    }
+  }
+};
+
+using CallStack = RawCallStack<kDefaultMaxStackDepth>;
+
+/** FNV-1a over the live addresses of a raw call stack. */
+struct CallStackHash {
+  template <size_t MaxDepth>
+  size_t operator()(const RawCallStack<MaxDepth> &stack) const {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < stack.num_frames; i++) {
+      h ^= stack.addresses[i];
+      h *= 1099511628211ull;
+    }
+    return static_cast<size_t>(h);
+  }
+};
+
+struct CallStackEqual {
+  template <size_t MaxDepth>
+  bool operator()(const RawCallStack<MaxDepth> &a,
+                  const RawCallStack<MaxDepth> &b) const {
+    // memcmp over the live prefix: the addresses are contiguous PODs,
+    // so the libc wide compare beats a per-element loop, and probes
+    // that reach the equality check nearly always match (the hash
+    // already agreed).
+    return a.num_frames == b.num_frames &&
+           std::memcmp(a.addresses.data(), b.addresses.data(),
+                       a.num_frames * sizeof(uint64_t)) == 0;
+  }
+};
+
+/** One frame of a resolved call stack: the raw address mapped back to a
+ * library plus (optionally) symbol information.
+ *
+ * The name fields are owning strings on purpose: resolved stacks are
+ * stored long-term (performance trees, serialized reports) and routinely
+ * outlive the LibraryMap snapshot they were decoded from, so id- or
+ * string_view-based frames would dangle or force every consumer to carry
+ * the originating snapshot around. */
+struct ResolvedFrame {
+  uint64_t raw_address = 0;  /**<address as sampled */
+  uint64_t offset = 0;       /**<offset within the library */
+  uint32_t line_number = 0;  /**<source line, 0 if unknown */
+  std::string library_name;  /**<mapped object path, "[unknown]" if none */
+  std::string function_name; /**<demangled function name, may be empty */
+  std::string filename;      /**<source file, may be empty */
+};
+
+/** A fully resolved call stack, leaf first. */
+struct ResolvedCallStack {
+  std::vector<ResolvedFrame> frames;
+};
+
+} // namespace sampling
+} // namespace perflow
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef PERFLOW_SAMPLING_DATA_IMPORTER_H_
+#define PERFLOW_SAMPLING_DATA_IMPORTER_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "perflow/sampling/call_stack.h"
+
+namespace perflow {
+namespace sampling {
+
+/** Aggregated counters for one unique call stack. */
+struct SampleAggregate {
+  uint64_t count = 0;
+  double total_time = 0.0;
+};
+
+/** Reads aggregated call-stack records from a binary .pflw sample file.
+ *
+ * Record layout (native endianness, packed back to back):
+ *   uint32_t num_frames            - 1..kDefaultMaxStackDepth
+ *   uint64_t addresses[num_frames] - leaf first
+ *   uint64_t count                 - samples attributed to this stack
+ *   double   total_time            - execution time attributed to it
+ */
+class DataImporter {
+public:
+  explicit DataImporter(std::string filepath)
+      : filepath_(std::move(filepath)) {}
+
+  /** Import all records, accumulating duplicates into @p out. The file
+   * is mapped read-only and decoded in place: no userspace copy of the
+   * file contents, and MADV_SEQUENTIAL|MADV_WILLNEED lets the kernel
+   * read ahead across the parallel readers instead of each of them
+   * duplicating its own buffering. Returns false on open failure or a
+   * malformed/truncated record. */
+  template <typename Map> bool importData(Map &out) {
+    int fd = ::open(filepath_.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+      ::close(fd);
+      return true;
+    }
+    void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+    ::madvise(mapped, size, MADV_SEQUENTIAL | MADV_WILLNEED);
+    bool ok = importFromBuffer(mapped, size, out);
+    ::munmap(mapped, size);
+    ::close(fd);
+    return ok;
+  }
+
+  /** Decode records from an in-memory image of a .pflw file. */
+  template <typename Map>
+  bool importFromBuffer(const void *data, size_t len, Map &out) {
+    const char *p = static_cast<const char *>(data);
+    const char *end = p + len;
+    while (p != end) {
+      uint32_t num_frames = 0;
+      if (static_cast<size_t>(end - p) < sizeof(num_frames)) {
+        return false;
+      }
+      std::memcpy(&num_frames, p, sizeof(num_frames));
+      p += sizeof(num_frames);
+      if (num_frames == 0 || num_frames > kDefaultMaxStackDepth) {
+        return false;
+      }
+      size_t payload = num_frames * sizeof(uint64_t) + sizeof(uint64_t) +
+                       sizeof(double);
+      if (static_cast<size_t>(end - p) < payload) {
+        return false;
+      }
+      CallStack stack;
+      std::memcpy(stack.addresses.data(), p, num_frames * sizeof(uint64_t));
+      stack.num_frames = num_frames;
+      p += num_frames * sizeof(uint64_t);
+
+      uint64_t count = 0;
+      double total_time = 0.0;
+      std::memcpy(&count, p, sizeof(count));
+      p += sizeof(count);
+      std::memcpy(&total_time, p, sizeof(total_time));
+      p += sizeof(total_time);
+
+      SampleAggregate *agg = out.find_or_insert(stack);
+      if (agg == nullptr) {
+        return false; // aggregation map full; undersized for this file
+      }
+      agg->count += count;
+      agg->total_time += total_time;
+    }
+    return true;
+  }
+
+  const std::string &filepath() const { return filepath_; }
+
+private:
+  std::string filepath_;
+};
+
+} // namespace sampling
+} // namespace perflow
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef PERFLOW_SAMPLING_LIBRARY_MAP_H_
+#define PERFLOW_SAMPLING_LIBRARY_MAP_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace perflow {
+namespace sampling {
+
+/** One mapped executable region of a shared library (or the main binary)
+ * in a process' address space. */
+struct LibraryRange {
+  uint64_t start;   /**<first address of the mapped region */
+  uint64_t end;     /**<one past the last address of the mapped region */
+  std::string name; /**<path of the mapped object */
+};
+
+/** Snapshot of the library load map of one process, e.g. one parse of
+ * /proc/<pid>/maps taken at sampling time. Ranges are kept sorted by start
+ * address so an address lookup is a binary search. */
+class LibraryMap {
+public:
+  /** Register a mapped region. Ranges may be added in any order. */
+  void add_library(uint64_t start, uint64_t end, std::string name) {
+    auto it = std::lower_bound(
+        ranges_.begin(), ranges_.end(), start,
+        [](const LibraryRange &r, uint64_t s) { return r.start < s; });
+    ranges_.insert(it, LibraryRange{start, end, std::move(name)});
+  }
+
+  /** Resolve a raw address to (library name, offset within the library).
+   * @param addr - raw sampled address.
+   * @return the pair on success, std::nullopt if no mapped region covers
+   * the address.
+   */
+  std::optional<std::pair<std::string, uint64_t>>
+  resolve(uint64_t addr) const {
+    const LibraryRange *r = find_range(addr);
+    if (r == nullptr) {
+      return std::nullopt;
+    }
+    return std::make_pair(r->name, addr - r->start);
+  }
+
+  /** Find the mapped region covering an address, nullptr if none does. */
+  const LibraryRange *find_range(uint64_t addr) const {
+    auto it = std::upper_bound(
+        ranges_.begin(), ranges_.end(), addr,
+        [](uint64_t a, const LibraryRange &r) { return a < r.start; });
+    if (it == ranges_.begin()) {
+      return nullptr;
+    }
+    --it;
+    if (addr >= it->start && addr < it->end) {
+      return &*it;
+    }
+    return nullptr;
+  }
+
+  size_t size() const { return ranges_.size(); }
+
+  const std::vector<LibraryRange> &ranges() const { return ranges_; }
+
+private:
+  std::vector<LibraryRange> ranges_; /**<sorted by start address */
+};
+
+} // namespace sampling
+} // namespace perflow
+
+#endif
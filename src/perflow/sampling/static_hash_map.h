@@ -0,0 +1,102 @@
+#ifndef PERFLOW_SAMPLING_STATIC_HASH_MAP_H_
+#define PERFLOW_SAMPLING_STATIC_HASH_MAP_H_
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace perflow {
+namespace sampling {
+
+/** Fixed-capacity open-addressed hash map (linear probing, no erase)
+ * used to aggregate duplicate call stacks while importing one sample
+ * file. The capacity is chosen at construction (rounded up to a power
+ * of two) and bounds the number of distinct keys; find_or_insert on a
+ * full table fails rather than growing. */
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class StaticHashMap {
+public:
+  static constexpr size_t kDefaultCapacity = size_t(1) << 20;
+  static constexpr size_t kMinCapacity = 1024;
+
+  explicit StaticHashMap(size_t capacity = kDefaultCapacity)
+      : slots_(round_up_pow2(capacity < kMinCapacity ? kMinCapacity
+                                                     : capacity)) {}
+
+  /** Return the value for key, default-constructing it on first use,
+   * or nullptr when the key is absent and the table is full. The probe
+   * count is bounded by the slot count, so a full table is detected
+   * instead of probing forever (an assert alone compiles out under
+   * NDEBUG). */
+  Value *find_or_insert(const Key &key) {
+    size_t mask = slots_.size() - 1;
+    size_t idx = hash_(key) & mask;
+    for (size_t probes = 0; probes <= mask; probes++) {
+      Slot &slot = slots_[idx];
+      if (!slot.used) {
+        slot.used = true;
+        slot.key = key;
+        size_++;
+        return &slot.value;
+      }
+      if (equal_(slot.key, key)) {
+        return &slot.value;
+      }
+      idx = (idx + 1) & mask;
+    }
+    return nullptr;
+  }
+
+  /** Invoke fn(key, value) for every occupied slot. */
+  template <typename Fn> void for_each(Fn &&fn) const {
+    for (const Slot &slot : slots_) {
+      if (slot.used) {
+        fn(slot.key, slot.value);
+      }
+    }
+  }
+
+  /** Forget all entries but keep the slot storage, so one map can be
+   * recycled across files instead of reallocating its slot array.
+   * Values of used slots are reset here because find_or_insert hands
+   * out slot values as default-constructed; stale keys need no reset,
+   * a reclaimed slot overwrites its key. */
+  void clear() {
+    for (Slot &slot : slots_) {
+      if (slot.used) {
+        slot.used = false;
+        slot.value = Value{};
+      }
+    }
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return slots_.size(); }
+
+private:
+  struct Slot {
+    bool used = false;
+    Key key;
+    Value value;
+  };
+
+  static size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+  Hash hash_;
+  Equal equal_;
+};
+
+} // namespace sampling
+} // namespace perflow
+
+#endif